@@ -70,7 +70,10 @@
   @return  Adafruit_NeoPixel object. Call the begin() function before use.
 */
 Adafruit_NeoPixel::Adafruit_NeoPixel(uint16_t n, uint16_t p, neoPixelType t) :
-  begun(false), brightness(0), pixels(NULL), endTime(0) {
+  begun(false), brightness(0), pixels(NULL), endTime(0), palette(NULL),
+  paletteSize(0), paletteUsed(0), lastColor(0), lastIndex(0), irqGroup(0),
+  resends(0), irqOffMax(0), bitLoopError(0), partialShow(false), dirtyEnd(0),
+  bytesSent(0) {
   updateType(t);
   updateLength(n);
   setPin(p);
@@ -91,7 +94,10 @@ Adafruit_NeoPixel::Adafruit_NeoPixel() :
   is800KHz(true),
 #endif
   begun(false), numLEDs(0), numBytes(0), pin(-1), brightness(0), pixels(NULL),
-  rOffset(1), gOffset(0), bOffset(2), wOffset(1), endTime(0) {
+  rOffset(1), gOffset(0), bOffset(2), wOffset(1), endTime(0), palette(NULL),
+  paletteSize(0), paletteUsed(0), lastColor(0), lastIndex(0), irqGroup(0),
+  resends(0), irqOffMax(0), bitLoopError(0), partialShow(false), dirtyEnd(0),
+  bytesSent(0) {
 }
 
 /*!
@@ -99,6 +105,7 @@ Adafruit_NeoPixel::Adafruit_NeoPixel() :
 */
 Adafruit_NeoPixel::~Adafruit_NeoPixel() {
   free(pixels);
+  free(palette);
   if(pin >= 0) pinMode(pin, INPUT);
 }
 
@@ -127,10 +134,14 @@ void Adafruit_NeoPixel::updateLength(uint16_t n) {
   free(pixels); // Free existing data (if any)
 
   // Allocate new data -- note: ALL PIXELS ARE CLEARED
+  // numBytes is always what goes out on the wire; in indexed mode only
+  // one index per pixel is stored.
   numBytes = n * ((wOffset == rOffset) ? 3 : 4);
-  if((pixels = (uint8_t *)malloc(numBytes))) {
-    memset(pixels, 0, numBytes);
+  uint16_t stored = paletteSize ? n : numBytes;
+  if((pixels = (uint8_t *)malloc(stored))) {
+    memset(pixels, 0, stored);
     numLEDs = n;
+    dirtyEnd = n;
   } else {
     numLEDs = numBytes = 0;
   }
@@ -164,6 +175,9 @@ void Adafruit_NeoPixel::updateType(neoPixelType t) {
   is800KHz = (t < 256);      // 400 KHz flag is 1<<8
 #endif
 
+  // Indexed mode only handles RGB pixels
+  if(paletteSize && (wOffset != rOffset)) setIndexed(0);
+
   // If bytes-per-pixel has changed (and pixel data was previously
   // allocated), re-allocate to new size. Will clear any data.
   if(pixels) {
@@ -196,6 +210,18 @@ void Adafruit_NeoPixel::show(void) {
 
   if(!pixels) return;
 
+  // Send only as far as the last pixel that changed, if at all. The LEDs
+  // past that keep what they were last sent.
+  uint32_t sendBytes = numBytes;
+#ifdef NEO_PARTIAL_SHOW
+  if(partialShow) {
+    sendBytes = (uint32_t)dirtyEnd * ((wOffset == rOffset) ? 3 : 4);
+    if(!sendBytes) return;
+  }
+#endif
+  dirtyEnd   = 0;
+  bytesSent += sendBytes;
+
   // Data latch = 300+ microsecond pause in the output stream. Rather than
   // put a delay at the end of the function, the ending time is noted and
   // the function will simply hold off (if needed) on issuing the
@@ -218,7 +244,8 @@ void Adafruit_NeoPixel::show(void) {
   // to the PORT register as needed.
 
   // NRF52 may use PWM + DMA (if available), may not need to disable interrupt
-#if !( defined(NRF52) || defined(NRF52_SERIES) )
+  // Apollo3 disables them itself, see setInterruptGroup()
+#if !( defined(NRF52) || defined(NRF52_SERIES) || defined(NEO_IRQ_GROUPS) )
   noInterrupts(); // Need 100% focus on instruction timing
 #endif
 
@@ -1702,7 +1729,9 @@ void Adafruit_NeoPixel::show(void) {
 
 #elif defined (AM_PART_APOLLO3) // Apollo3
 
-  apollo3Show(pin, pixels, numBytes, is800KHz);
+  // brightness is stored +1 with 0 for full, see setBrightness()
+  apollo3Show(pin, pixels, sendBytes, is800KHz, paletteSize ? palette : NULL,
+              brightness ? brightness : 256);
 
 #elif defined (__SAMD51__) // M4
 
@@ -2201,7 +2230,7 @@ void Adafruit_NeoPixel::show(void) {
 
 // END ARCHITECTURE SELECT ------------------------------------------------
 
-#if !( defined(NRF52) || defined(NRF52_SERIES) )
+#if !( defined(NRF52) || defined(NRF52_SERIES) || defined(NEO_IRQ_GROUPS) )
   interrupts();
 #endif
 
@@ -2252,22 +2281,8 @@ void Adafruit_NeoPixel::setPin(uint16_t p) {
 void Adafruit_NeoPixel::setPixelColor(
  uint16_t n, uint8_t r, uint8_t g, uint8_t b) {
 
-  if(n < numLEDs) {
-    if(brightness) { // See notes in setBrightness()
-      r = (r * brightness) >> 8;
-      g = (g * brightness) >> 8;
-      b = (b * brightness) >> 8;
-    }
-    uint8_t *p;
-    if(wOffset == rOffset) { // Is an RGB-type strip
-      p = &pixels[n * 3];    // 3 bytes per pixel
-    } else {                 // Is a WRGB-type strip
-      p = &pixels[n * 4];    // 4 bytes per pixel
-      p[wOffset] = 0;        // But only R,G,B passed -- set W to 0
-    }
-    p[rOffset] = r;          // R,G,B always stored
-    p[gOffset] = g;
-    p[bOffset] = b;
+  if(n < numLEDs) { // W is set to 0 on WRGB strips
+    putPixel(n, Color(r, g, b));
   }
 }
 
@@ -2284,23 +2299,8 @@ void Adafruit_NeoPixel::setPixelColor(
 void Adafruit_NeoPixel::setPixelColor(
  uint16_t n, uint8_t r, uint8_t g, uint8_t b, uint8_t w) {
 
-  if(n < numLEDs) {
-    if(brightness) { // See notes in setBrightness()
-      r = (r * brightness) >> 8;
-      g = (g * brightness) >> 8;
-      b = (b * brightness) >> 8;
-      w = (w * brightness) >> 8;
-    }
-    uint8_t *p;
-    if(wOffset == rOffset) { // Is an RGB-type strip
-      p = &pixels[n * 3];    // 3 bytes per pixel (ignore W)
-    } else {                 // Is a WRGB-type strip
-      p = &pixels[n * 4];    // 4 bytes per pixel
-      p[wOffset] = w;        // Store W
-    }
-    p[rOffset] = r;          // Store R,G,B
-    p[gOffset] = g;
-    p[bOffset] = b;
+  if(n < numLEDs) { // W is ignored on RGB strips, and in indexed mode
+    putPixel(n, Color(r, g, b, w));
   }
 }
 
@@ -2313,25 +2313,7 @@ void Adafruit_NeoPixel::setPixelColor(
 */
 void Adafruit_NeoPixel::setPixelColor(uint16_t n, uint32_t c) {
   if(n < numLEDs) {
-    uint8_t *p,
-      r = (uint8_t)(c >> 16),
-      g = (uint8_t)(c >>  8),
-      b = (uint8_t)c;
-    if(brightness) { // See notes in setBrightness()
-      r = (r * brightness) >> 8;
-      g = (g * brightness) >> 8;
-      b = (b * brightness) >> 8;
-    }
-    if(wOffset == rOffset) {
-      p = &pixels[n * 3];
-    } else {
-      p = &pixels[n * 4];
-      uint8_t w = (uint8_t)(c >> 24);
-      p[wOffset] = brightness ? ((w * brightness) >> 8) : w;
-    }
-    p[rOffset] = r;
-    p[gOffset] = g;
-    p[bOffset] = b;
+    putPixel(n, c);
   }
 }
 
@@ -2368,6 +2350,115 @@ void Adafruit_NeoPixel::fill(uint32_t c, uint16_t first, uint16_t count) {
   }
 }
 
+/*!
+  @brief   Set a run of consecutive pixels from an array of colors, in one
+           pass and without a virtual call per pixel.
+  @param   first   Index of the first pixel to set.
+  @param   colors  'Packed' 32-bit RGB or WRGB colors, one per pixel.
+  @param   count   Number of pixels to set. Any past the end of the strip
+                   are ignored.
+*/
+void Adafruit_NeoPixel::setPixelColors(uint16_t first, const uint32_t *colors,
+  uint16_t count) {
+  writeSpan(first, 1, colors, 0, 0, count);
+}
+
+/*!
+  @brief   Set up to 32 pixels from a bitmask to one color, converting the
+           color just once.
+  @param   first  Index of the pixel bit 0 of the mask stands for.
+  @param   mask   Bit n set means pixel first + n is set to the color,
+                  clear bits leave their pixel alone.
+  @param   c      'Packed' 32-bit RGB or WRGB color.
+*/
+void Adafruit_NeoPixel::fillMask(uint16_t first, uint32_t mask, uint32_t c) {
+  writeSpan(first, 1, NULL, mask, c, 32);
+}
+
+/*!
+  @brief   Write a run of pixels, which subclasses that rearrange pixels
+           can override to split or reverse runs.
+  @param   first   Index of the first pixel written.
+  @param   step    1 to write upwards from first, -1 to write downwards.
+  @param   colors  One color per pixel, or NULL to use mask and c.
+  @param   mask    Without colors: bit n set means the nth pixel of the run
+                   is set to c. Only the first 32 pixels can be set.
+  @param   c       Without colors: the color for pixels in the mask.
+  @param   count   Length of the run. Pixels outside the strip are ignored.
+*/
+void Adafruit_NeoPixel::writeSpan(uint16_t first, int8_t step,
+  const uint32_t *colors, uint32_t mask, uint32_t c, uint16_t count) {
+
+  if(!colors) {
+    if(count > 32) count = 32;
+    mask &= (count < 32) ? ((1UL << count) - 1) : 0xFFFFFFFF;
+  }
+
+  uint8_t bytes = (wOffset == rOffset) ? 3 : 4, fillIndex = 0, fill[4];
+  if(!colors) { // Same color for every pixel: convert it once
+    if(paletteSize) fillIndex = paletteIndex(c);
+    else            storeColor(fill, c);
+  }
+
+  int32_t n = first;
+  for(uint16_t i=0; i<count; i++, n+=step) {
+    if(!colors && !(mask & (1UL << i))) continue;
+    if((n < 0) || (n >= numLEDs)) continue;
+    if(colors)           putPixel(n, colors[i]);
+    else if(paletteSize) putIndex(n, fillIndex);
+    else                 putBytes(n, fill, bytes);
+  }
+}
+
+// Sets pixel n, which must be on the strip, to a packed color.
+void Adafruit_NeoPixel::putPixel(uint16_t n, uint32_t c) {
+  if(paletteSize) {
+    putIndex(n, paletteIndex(c));
+  } else {
+    uint8_t bytes = (wOffset == rOffset) ? 3 : 4, b[4];
+    storeColor(b, c);
+    putBytes(n, b, bytes);
+  }
+}
+
+// Sets pixel n to a palette index, noting it for show() if it changed.
+void Adafruit_NeoPixel::putIndex(uint16_t n, uint8_t i) {
+  if(pixels[n] != i) {
+    pixels[n] = i;
+    if(n >= dirtyEnd) dirtyEnd = n + 1;
+  }
+}
+
+// Sets pixel n to bytes already in the strip's order, noting it for show()
+// if it changed.
+void Adafruit_NeoPixel::putBytes(uint16_t n, const uint8_t *b,
+  uint8_t bytes) {
+  uint8_t *p = &pixels[n * bytes];
+  if(memcmp(p, b, bytes)) {
+    memcpy(p, b, bytes);
+    if(n >= dirtyEnd) dirtyEnd = n + 1;
+  }
+}
+
+// Stores a packed color at p in the strip's byte order, scaled by the
+// brightness unless show() does that.
+void Adafruit_NeoPixel::storeColor(uint8_t *p, uint32_t c) const {
+  uint8_t r = (uint8_t)(c >> 16), g = (uint8_t)(c >> 8), b = (uint8_t)c,
+          w = (uint8_t)(c >> 24);
+#ifndef NEO_SCALE_ON_SHOW
+  if(brightness) { // See notes in setBrightness()
+    r = (r * brightness) >> 8;
+    g = (g * brightness) >> 8;
+    b = (b * brightness) >> 8;
+    w = (w * brightness) >> 8;
+  }
+#endif
+  if(wOffset != rOffset) p[wOffset] = w;
+  p[rOffset] = r;
+  p[gOffset] = g;
+  p[bOffset] = b;
+}
+
 /*!
   @brief   Convert hue, saturation and value into a packed 32-bit RGB color
            that can be passed to setPixelColor() or other RGB-compatible
@@ -2476,16 +2567,30 @@ uint32_t Adafruit_NeoPixel::ColorHSV(uint16_t hue, uint8_t sat, uint8_t val) {
   @note    If the strip brightness has been changed from the default value
            of 255, the color read from a pixel may not exactly match what
            was previously written with one of the setPixelColor() functions.
-           This gets more pronounced at lower brightness levels.
+           This gets more pronounced at lower brightness levels. Where
+           show() applies the brightness (NEO_SCALE_ON_SHOW), it always
+           matches.
 */
 uint32_t Adafruit_NeoPixel::getPixelColor(uint16_t n) const {
   if(n >= numLEDs) return 0; // Out of bounds, return no color.
 
   uint8_t *p;
+#ifdef NEO_SCALE_ON_SHOW
+  const boolean scaled = false; // Colors are stored as they were set
+#else
+  const boolean scaled = brightness;
+#endif
+
+  if(paletteSize) { // Indexed mode, RGB only
+    p = &palette[pixels[n] * 3];
+    return ((uint32_t)p[rOffset] << 16) |
+           ((uint32_t)p[gOffset] <<  8) |
+            (uint32_t)p[bOffset];
+  }
 
   if(wOffset == rOffset) { // Is RGB-type device
     p = &pixels[n * 3];
-    if(brightness) {
+    if(scaled) {
       // Stored color was decimated by setBrightness(). Returned value
       // attempts to scale back to an approximation of the original 24-bit
       // value used when setting the pixel color, but there will always be
@@ -2502,7 +2607,7 @@ uint32_t Adafruit_NeoPixel::getPixelColor(uint16_t n) const {
     }
   } else {                 // Is RGBW-type device
     p = &pixels[n * 4];
-    if(brightness) { // Return scaled color
+    if(scaled) { // Return scaled color
       return (((uint32_t)(p[wOffset] << 8) / brightness) << 24) |
              (((uint32_t)(p[rOffset] << 8) / brightness) << 16) |
              (((uint32_t)(p[gOffset] << 8) / brightness) <<  8) |
@@ -2522,6 +2627,8 @@ uint32_t Adafruit_NeoPixel::getPixelColor(uint16_t n) const {
            currently displayed on the LEDs. The next call to show() will
            refresh the LEDs at this level.
   @param   b  Brightness setting, 0=minimum (off), 255=brightest.
+  @note    Where show() applies the brightness (NEO_SCALE_ON_SHOW), this
+           just stores it, and none of what follows applies.
   @note    This was intended for one-time use in one's setup() function,
            not as an animation effect in itself. Because of the way this
            library "pre-multiplies" LED colors in RAM, changing the
@@ -2540,6 +2647,10 @@ void Adafruit_NeoPixel::setBrightness(uint8_t b) {
   // (color values are interpreted literally; no scaling), 1 = min
   // brightness (off), 255 = just below max brightness.
   uint8_t newBrightness = b + 1;
+#ifdef NEO_SCALE_ON_SHOW
+  if(newBrightness != brightness) dirtyEnd = numLEDs; // Every pixel changes
+  brightness = newBrightness;
+#else
   if(newBrightness != brightness) { // Compare against prior value
     // Brightness has changed -- re-scale existing data in RAM,
     // This process is potentially "lossy," especially when increasing
@@ -2563,7 +2674,9 @@ void Adafruit_NeoPixel::setBrightness(uint8_t b) {
       *ptr++ = (c * scale) >> 8;
     }
     brightness = newBrightness;
+    dirtyEnd   = numLEDs;
   }
+#endif
 }
 
 /*!
@@ -2574,11 +2687,166 @@ uint8_t Adafruit_NeoPixel::getBrightness(void) const {
   return brightness - 1;
 }
 
+/*!
+  @brief   Let interrupts run while show() is sending. Normally they are
+           off for the whole frame, which at 400 KHz is about 60
+           microseconds per RGB pixel. Instead, they can be turned back on
+           for a moment after every few pixels. The data line sits low in
+           the meantime, which the LEDs take as a pause rather than the
+           end of the frame as long as it's short. If an interrupt handler
+           runs long enough that they might have latched what they got so
+           far, show() waits for the latch and sends the frame again, and
+           after a couple of tries gives up and sends it with interrupts
+           off.
+  @param   pixels  Pixels sent with interrupts off at a time, or 0 to keep
+                   them off for the whole frame (the default).
+  @note    Only platforms that define NEO_IRQ_GROUPS do this; elsewhere
+           this does nothing.
+*/
+void Adafruit_NeoPixel::setInterruptGroup(uint8_t pixels) {
+  irqGroup = pixels;
+}
+
+/*!
+  @brief   Longest time show() has kept interrupts off, as measured with the
+           CPU cycle counter. With setInterruptGroup() that's one group of
+           pixels, otherwise a whole frame.
+  @return  Microseconds, or 0 where it isn't measured (no
+           NEO_IRQ_GROUPS).
+*/
+uint32_t Adafruit_NeoPixel::getMaxInterruptsOff(void) const {
+#ifdef NEO_IRQ_GROUPS
+  return irqOffMax / NEO_CYCLES_PER_US;
+#else
+  return 0;
+#endif
+}
+
+/*!
+  @brief   Have show() send pixels only up to the last one that changed
+           since the previous show(), and nothing at all if none did.
+           NeoPixels keep whatever they were last sent, so the rest stay
+           as they are. A frame that only changes the first few pixels
+           then takes a fraction of the time.
+  @param   on  true to send just the changed part, false to always send
+               every pixel (the default).
+  @note    Only platforms that define NEO_PARTIAL_SHOW do this. Changes
+           made through getPixels() go unnoticed, so don't mix the two.
+*/
+void Adafruit_NeoPixel::setPartialShow(boolean on) {
+  partialShow = on;
+  dirtyEnd    = numLEDs; // Start from a full frame
+}
+
 /*!
   @brief   Fill the whole NeoPixel strip with 0 / black / off.
 */
 void Adafruit_NeoPixel::clear(void) {
-  memset(pixels, 0, numBytes);
+  memset(pixels, 0, paletteSize ? numLEDs : numBytes); // Index 0 is black
+  dirtyEnd = numLEDs;
+}
+
+/*!
+  @brief   Store each pixel as an index into a palette of colors instead of
+           as the color itself, or go back to storing colors. Pixels are
+           set the same way either way: setPixelColor() finds the color in
+           the palette or adds it, and show() looks colors up as it sends
+           them. All pixels are cleared.
+  @param   entries  Palette size, 2 to 255, or 0 to store colors again.
+                    Entries no pixel uses anymore are reclaimed when the
+                    palette fills up. If it's still full, the nearest color
+                    in it is used instead.
+  @return  true on success, false if show() on this platform can't send
+           indexed pixels, the pixels are RGBW, or out of memory.
+*/
+boolean Adafruit_NeoPixel::setIndexed(uint8_t entries) {
+#ifdef NEO_INDEXED
+  if(entries && ((entries < 2) || (wOffset != rOffset))) return false;
+
+  free(palette);
+  palette = NULL;
+  paletteSize = paletteUsed = 0;
+
+  boolean ok = true;
+  if(entries) {
+    if((palette = (uint8_t *)malloc(entries * 3))) {
+      memset(palette, 0, 3); // Entry 0 is black, and stays that way
+      paletteSize = entries;
+      paletteUsed = 1;
+      lastColor   = 0;
+      lastIndex   = 0;
+    } else {
+      ok = false;
+    }
+  }
+  updateLength(numLEDs);
+  return ok && pixels;
+#else
+  return entries == 0;
+#endif
+}
+
+// Returns the palette index for a packed RGB color, adding it if needed.
+uint8_t Adafruit_NeoPixel::paletteIndex(uint32_t c) {
+  c &= 0xFFFFFF;
+  // Runs of the same color (black, mostly) are the common case
+  if(c == lastColor) return lastIndex;
+
+  uint8_t r = (uint8_t)(c >> 16), g = (uint8_t)(c >> 8), b = (uint8_t)c;
+  uint8_t i, *p = palette;
+  for(i=0; i<paletteUsed; i++, p+=3) {
+    if((p[rOffset] == r) && (p[gOffset] == g) && (p[bOffset] == b)) break;
+  }
+
+  if(i == paletteUsed) {
+    if(paletteUsed == paletteSize) packPalette();
+    if(paletteUsed < paletteSize) {
+      i = paletteUsed++;
+      p = &palette[i * 3];
+      p[rOffset] = r;
+      p[gOffset] = g;
+      p[bOffset] = b;
+    } else {
+      // Palette is full of colors in use: settle for the closest one
+      uint16_t best = 0xFFFF;
+      p = palette;
+      for(uint8_t j=0; j<paletteUsed; j++, p+=3) {
+        uint16_t d = abs(p[rOffset] - r) + abs(p[gOffset] - g) +
+                     abs(p[bOffset] - b);
+        if(d < best) {
+          best = d;
+          i    = j;
+        }
+      }
+    }
+  }
+
+  lastColor = c;
+  lastIndex = i;
+  return i;
+}
+
+// Drops palette entries that no pixel uses and closes the gaps, moving the
+// indices in the pixels to match.
+void Adafruit_NeoPixel::packPalette(void) {
+  uint8_t used[32], remap[256];
+  memset(used, 0, sizeof(used));
+  used[0] = 1; // Black stays
+  for(uint16_t n=0; n<numLEDs; n++) used[pixels[n] >> 3] |= 1 << (pixels[n] & 7);
+
+  uint8_t kept = 0;
+  for(uint8_t i=0; i<paletteUsed; i++) {
+    if(used[i >> 3] & (1 << (i & 7))) {
+      if(kept != i) memcpy(&palette[kept * 3], &palette[i * 3], 3);
+      remap[i] = kept++;
+    }
+  }
+  if(kept == paletteUsed) return; // Everything's in use
+
+  for(uint16_t n=0; n<numLEDs; n++) pixels[n] = remap[pixels[n]];
+  paletteUsed = kept;
+  lastColor   = 0;
+  lastIndex   = 0;
 }
 
 // A 32-bit variant of gamma8() that applies the same function
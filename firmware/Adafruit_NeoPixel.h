@@ -139,6 +139,24 @@ typedef uint16_t neoPixelType; ///< 3rd arg to Adafruit_NeoPixel constructor
 typedef uint8_t  neoPixelType; ///< 3rd arg to Adafruit_NeoPixel constructor
 #endif
 
+// On the Apollo3, show() applies the brightness to each byte as it sends
+// it, and can look colors up in a palette (see setIndexed()). Pixels are
+// then kept exactly as they were set, and setBrightness() is instant and
+// lossless. Elsewhere the brightness is applied as pixels are set.
+#if defined(AM_PART_APOLLO3) && !defined(NEO_SCALE_ON_SHOW)
+#define NEO_SCALE_ON_SHOW ///< show() applies the brightness
+#endif
+#if defined(NEO_SCALE_ON_SHOW) && !defined(NEO_INDEXED)
+#define NEO_INDEXED ///< show() supports indexed mode
+#endif
+// The Apollo3 show() can also let interrupts run between pixels, see
+// setInterruptGroup().
+#if defined(AM_PART_APOLLO3)
+#define NEO_IRQ_GROUPS ///< show() supports interrupt windows
+#define NEO_CYCLES_PER_US (AM_HAL_CLKGEN_FREQ_MAX_HZ / 1000000) ///< Core clock
+#define NEO_PARTIAL_SHOW ///< show() can stop after the last changed pixel
+#endif
+
 // These two tables are declared outside the Adafruit_NeoPixel class
 // because some boards may require oldschool compilers that don't
 // handle the C++11 constexpr keyword.
@@ -216,10 +234,44 @@ class Adafruit_NeoPixel {
                       uint8_t w);
   virtual void      setPixelColor(uint16_t n, uint32_t c);
   void              fill(uint32_t c=0, uint16_t first=0, uint16_t count=0);
+  void              setPixelColors(uint16_t first, const uint32_t *colors,
+                      uint16_t count);
+  void              fillMask(uint16_t first, uint32_t mask, uint32_t c);
   void              setBrightness(uint8_t);
   void              clear(void);
   void              updateLength(uint16_t n);
   void              updateType(neoPixelType t);
+  boolean           setIndexed(uint8_t entries);
+  /*!
+    @brief   Check whether pixels are stored as palette indices.
+    @return  true if setIndexed() turned indexed mode on.
+  */
+  boolean           isIndexed(void) const { return paletteSize != 0; }
+  void              setInterruptGroup(uint8_t pixels);
+  uint32_t          getMaxInterruptsOff(void) const;
+  /*!
+    @brief   Count the frames that had to be sent again because interrupts
+             ran long enough between pixels for the LEDs to latch early.
+    @return  Resends so far, see setInterruptGroup().
+  */
+  uint16_t          getResends(void) const { return resends; }
+  /*!
+    @brief   Check the cycle counts the bit timings were worked out from
+             against the hardware. show() times the first byte of each
+             frame with the CPU cycle counter.
+    @return  Cycles that byte took beyond what the timings expect, within
+             a few either way when they're right. Each cycle a bit takes
+             that wasn't counted adds 8. 0 where it isn't measured (no
+             NEO_IRQ_GROUPS).
+  */
+  int16_t           getBitLoopError(void) const { return bitLoopError; }
+  void              setPartialShow(boolean on);
+  /*!
+    @brief   Count the bytes show() has sent, to see how much
+             setPartialShow() saves.
+    @return  Bytes sent so far, 3 or 4 per pixel.
+  */
+  uint32_t          getBytesSent(void) const { return bytesSent; }
   /*!
     @brief   Check whether a call to show() will start sending data
              immediately or will 'block' for a required interval. NeoPixels
@@ -246,7 +298,9 @@ class Adafruit_NeoPixel {
              POV or light-painting projects). There is no bounds checking
              on the array, creating tremendous potential for mayhem if one
              writes past the ends of the buffer. Great power, great
-             responsibility and all that.
+             responsibility and all that. In indexed mode the buffer holds
+             one palette index per pixel instead. Changes made here aren't
+             seen by setPartialShow().
   */
   uint8_t          *getPixels(void) const { return pixels; };
   uint8_t           getBrightness(void) const;
@@ -339,8 +393,18 @@ class Adafruit_NeoPixel {
 #if defined (AM_PART_APOLLO3)
   void apollo3UnsetPad(ap3_gpio_pad_t pad);
   void apollo3SetPad(ap3_gpio_pad_t pad);
-  void apollo3Show(ap3_gpio_pad_t pad, uint8_t *pixels, uint32_t numBytes, boolean is800KHz);
+  void apollo3Show(ap3_gpio_pad_t pad, uint8_t *pixels, uint32_t numBytes, boolean is800KHz,
+                   const uint8_t *palette, uint16_t scale);
 #endif // AM_PART_APOLLO3
+  virtual void      writeSpan(uint16_t first, int8_t step,
+                      const uint32_t *colors, uint32_t mask, uint32_t c,
+                      uint16_t count);
+  void              storeColor(uint8_t *p, uint32_t c) const;
+  void              putPixel(uint16_t n, uint32_t c);
+  void              putIndex(uint16_t n, uint8_t i);
+  void              putBytes(uint16_t n, const uint8_t *b, uint8_t bytes);
+  uint8_t           paletteIndex(uint32_t c);
+  void              packPalette(void);
 
 #ifdef NEO_KHZ400  // If 400 KHz NeoPixel support enabled...
   boolean           is800KHz;   ///< true if 800 KHz pixels
@@ -356,6 +420,18 @@ class Adafruit_NeoPixel {
   uint8_t           bOffset;    ///< Index of blue byte
   uint8_t           wOffset;    ///< Index of white (==rOffset if no white)
   uint32_t          endTime;    ///< Latch timing reference
+  uint8_t          *palette;    ///< Indexed mode: colors in wire order, 3 bytes each
+  uint8_t           paletteSize; ///< Palette entries, 0 when not indexed
+  uint8_t           paletteUsed; ///< Entries in use, entry 0 is always black
+  uint32_t          lastColor;  ///< Last color looked up in the palette...
+  uint8_t           lastIndex;  ///< ...and where it was found
+  uint8_t           irqGroup;   ///< Pixels sent per interrupts-off window, 0 for all
+  uint16_t          resends;    ///< Frames started over, see getResends()
+  uint32_t          irqOffMax;  ///< Longest interrupts-off window, CPU cycles
+  int16_t           bitLoopError; ///< See getBitLoopError()
+  boolean           partialShow; ///< show() stops after the last changed pixel
+  uint16_t          dirtyEnd;   ///< One past the last pixel changed since show()
+  uint32_t          bytesSent;  ///< Total sent by show()
 #ifdef __AVR__
   volatile uint8_t *port;       ///< Output PORT register
   uint8_t           pinMask;    ///< Output PORT bitmask
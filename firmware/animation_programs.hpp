@@ -0,0 +1,77 @@
+#pragma once
+// Generated by tools/animasm.py from tools/animations, do not edit.
+
+static const uint8_t PROGRAM_CYCLE_COLORS[] = {
+    0x0D, 0x00, 0x03,            // in      r0, wheel       ; color of the last digit changed
+    0x0D, 0x04, 0x02,            // in      r4, second      ; last second seen
+    0x0D, 0x05, 0x04,            // in      r5, button      ; last button count seen
+    0x02, 0x06, 0x06, 0x00,      // ldi     r6, 6           ; number of digits
+    0x13, 0xFF, 0x00,            // color   all, r0
+    0x0D, 0x01, 0x04,            // in      r1, button
+    0x05, 0x01, 0x05,            // sub     r1, r5
+    0x0F, 0x01, 0x1F,            // jz      r1, no_press
+    0x0D, 0x05, 0x04,            // in      r5, button
+    0x0D, 0x00, 0x03,            // in      r0, wheel
+    0x0D, 0x01, 0x02,            // in      r1, second
+    0x05, 0x01, 0x04,            // sub     r1, r4
+    0x0F, 0x01, 0x3C,            // jz      r1, done
+    0x0D, 0x04, 0x02,            // in      r4, second
+    0x02, 0x02, 0x00, 0x00,      // ldi     r2, 0
+    0x06, 0x00, 0x10,            // addi    r0, 16
+    0x13, 0x82, 0x00,            // color   r2, r0
+    0x06, 0x02, 0x01,            // addi    r2, 1
+    0x11, 0x02, 0x06, 0x2F,      // jlt     r2, r6, next_digit
+    0x01,                        // yield
+    0x0E, 0x10,                  // jmp     frame
+};
+
+static const uint8_t PROGRAM_GLOW[] = {
+    0x02, 0x00, 0xFF, 0x00,      // ldi     r0, 255         ; brightness
+    0x02, 0x01, 0x19, 0x00,      // ldi     r1, 25          ; change per step, starts going up
+    0x02, 0x05, 0xFF, 0x00,      // ldi     r5, 255         ; brightest
+    0x02, 0x06, 0x66, 0x00,      // ldi     r6, 102         ; dimmest
+    0x02, 0x07, 0x19, 0x00,      // ldi     r7, 25          ; ms per step
+    0x0D, 0x02, 0x00,            // in      r2, millis      ; time of the last step
+    0x0D, 0x03, 0x03,            // in      r3, wheel
+    0x13, 0xFF, 0x03,            // color   all, r3
+    0x14, 0xFF, 0x00,            // bright  all, r0
+    0x0D, 0x03, 0x00,            // in      r3, millis
+    0x05, 0x03, 0x02,            // sub     r3, r2
+    0x11, 0x03, 0x07, 0x48,      // jlt     r3, r7, done
+    0x0D, 0x02, 0x00,            // in      r2, millis
+    0x04, 0x00, 0x01,            // add     r0, r1
+    0x12, 0x05, 0x00, 0x3D,      // jge     r5, r0, not_top
+    0x03, 0x00, 0x05,            // mov     r0, r5
+    0x02, 0x01, 0xFA, 0xFF,      // ldi     r1, -6
+    0x0E, 0x48,                  // jmp     done
+    0x12, 0x00, 0x06, 0x48,      // jge     r0, r6, done
+    0x03, 0x00, 0x06,            // mov     r0, r6
+    0x02, 0x01, 0x06, 0x00,      // ldi     r1, 6
+    0x01,                        // yield
+    0x0E, 0x17,                  // jmp     frame
+};
+
+static const uint8_t PROGRAM_RAINBOW[] = {
+    0x02, 0x00, 0x00, 0x00,      // ldi     r0, 0           ; first digit's color, in 1/256ths
+    0x02, 0x06, 0x06, 0x00,      // ldi     r6, 6           ; number of digits
+    0x02, 0x07, 0x01, 0x00,      // ldi     r7, 1
+    0x0D, 0x01, 0x04,            // in      r1, button
+    0x0B, 0x01, 0x07,            // and     r1, r7
+    0x10, 0x01, 0x18,            // jnz     r1, paused
+    0x06, 0x00, 0x1A,            // addi    r0, 26          ; about 0.1 per frame
+    0x03, 0x03, 0x00,            // mov     r3, r0
+    0x08, 0x03, 0x08,            // shr     r3, 8
+    0x02, 0x02, 0x00, 0x00,      // ldi     r2, 0
+    0x13, 0x82, 0x03,            // color   r2, r3
+    0x06, 0x03, 0x0C,            // addi    r3, 12
+    0x06, 0x02, 0x01,            // addi    r2, 1
+    0x11, 0x02, 0x06, 0x22,      // jlt     r2, r6, next_digit
+    0x01,                        // yield
+    0x0E, 0x0C,                  // jmp     frame
+};
+
+static const AnimationProgram ANIMATION_PROGRAMS[] = {
+    {ANIM_CYCLE_COLORS, PROGRAM_CYCLE_COLORS, sizeof(PROGRAM_CYCLE_COLORS), 0},
+    {ANIM_GLOW, PROGRAM_GLOW, sizeof(PROGRAM_GLOW), 25},
+    {ANIM_RAINBOW, PROGRAM_RAINBOW, sizeof(PROGRAM_RAINBOW), 16},
+};
@@ -0,0 +1,253 @@
+#pragma once
+#include <stdint.h>
+
+#include "Adafruit_NeoPixel.h"
+
+// A tiny interpreter for animation programs, so a new animation can be a
+// few dozen bytes of bytecode in a table instead of a new Animator subclass.
+// Programs are written in assembly under tools/animations and turned into
+// animation_programs.hpp by tools/animasm.py, which reads the opcode and
+// input names below, so keep them in sync when changing them.
+//
+// A program drives a wheel color and a brightness for each digit. It runs
+// like a coroutine: each frame picks up where the last one stopped, and
+// YIELD ends the frame. A frame also ends after MAX_STEPS_PER_FRAME
+// instructions no matter what, so a program can never stall the display.
+//
+// Instructions are an opcode byte followed by its operands, one byte each
+// except for LDI's 16-bit immediate (low byte first):
+//   r, s   registers R0..R7
+//   imm    signed 8-bit immediate
+//   addr   absolute address in the program, which is at most 255 bytes
+//   port   one of Input_e
+//   digit  0..5, ALL_DIGITS, or DIGIT_IN_REGISTER | r
+class AnimationVm
+{
+  public:
+    enum Opcode_e
+    {
+        OP_HALT,   //                  stop for good
+        OP_YIELD,  //                  end this frame
+        OP_LDI,    // r, imm16         r = imm16
+        OP_MOV,    // r, s             r = s
+        OP_ADD,    // r, s             r += s
+        OP_SUB,    // r, s             r -= s
+        OP_ADDI,   // r, imm           r += imm
+        OP_SHL,    // r, imm           r <<= imm
+        OP_SHR,    // r, imm           r >>= imm
+        OP_MIN,    // r, s             r = min(r, s)
+        OP_MAX,    // r, s             r = max(r, s)
+        OP_AND,    // r, s             r &= s
+        OP_SIN,    // r, s             r = sine8(s), 0..255
+        OP_IN,     // r, port          r = input
+        OP_JMP,    // addr
+        OP_JZ,     // r, addr          jump if r == 0
+        OP_JNZ,    // r, addr          jump if r != 0
+        OP_JLT,    // r, s, addr       jump if r < s
+        OP_JGE,    // r, s, addr       jump if r >= s
+        OP_COLOR,  // digit, s         wheel color = s & 0xFF
+        OP_BRIGHT, // digit, s         brightness = s, clamped to 0..255
+
+        TOTAL_OPCODES,
+    };
+
+    enum Input_e
+    {
+        IN_MILLIS, // millis()
+        IN_MS,     // ms since the current second began
+        IN_SECOND, // 0..59
+        IN_WHEEL,  // wheel color chosen with the C button
+        IN_BUTTON, // number of times the C button was pressed
+
+        TOTAL_INPUTS,
+    };
+
+    enum
+    {
+        NUM_REGISTERS = 8,
+        MAX_STEPS_PER_FRAME = 64,
+
+        ALL_DIGITS = 0xFF,
+        DIGIT_IN_REGISTER = 0x80,
+    };
+
+    int32_t inputs[TOTAL_INPUTS] = {0};
+    uint8_t wheel[NUM_DIGITS] = {0};
+    uint8_t brightness[NUM_DIGITS] = {0};
+
+  private:
+    const uint8_t *m_code{nullptr};
+    uint8_t m_length{0};
+    uint8_t m_pc{0};
+    bool m_halted{true};
+    int32_t m_registers[NUM_REGISTERS] = {0};
+
+  public:
+    void Load(const uint8_t *code, const uint8_t length)
+    {
+        m_code = code;
+        m_length = length;
+        m_pc = 0;
+        m_halted = false;
+    }
+
+    void RunFrame()
+    {
+        for (int step = 0; step < MAX_STEPS_PER_FRAME && !m_halted; ++step)
+        {
+            if (!Step())
+            {
+                return;
+            }
+        }
+    }
+
+  private:
+    // Returns false at the end of the frame
+    bool Step()
+    {
+        const uint8_t op = Fetch();
+        switch (op)
+        {
+        case OP_YIELD:
+            return false;
+
+        case OP_LDI:
+        {
+            int32_t &r = Reg();
+            const uint8_t low = Fetch();
+            r = (int16_t)(low | (Fetch() << 8));
+            break;
+        }
+
+        case OP_MOV:
+        case OP_ADD:
+        case OP_SUB:
+        case OP_MIN:
+        case OP_MAX:
+        case OP_AND:
+        case OP_SIN:
+        {
+            int32_t &r = Reg();
+            const int32_t s = Reg();
+            // arithmetic wraps around instead of overflowing
+            r = op == OP_MOV   ? s
+                : op == OP_ADD ? (int32_t)((uint32_t)r + s)
+                : op == OP_SUB ? (int32_t)((uint32_t)r - s)
+                : op == OP_MIN ? (s < r ? s : r)
+                : op == OP_MAX ? (s > r ? s : r)
+                : op == OP_AND ? r & s
+                               : Adafruit_NeoPixel::sine8(s);
+            break;
+        }
+
+        case OP_ADDI:
+        case OP_SHL:
+        case OP_SHR:
+        {
+            int32_t &r = Reg();
+            const int8_t imm = Fetch();
+            r = op == OP_ADDI  ? (int32_t)((uint32_t)r + imm)
+                : op == OP_SHL ? (int32_t)((uint32_t)r << (imm & 31))
+                               : r >> (imm & 31);
+            break;
+        }
+
+        case OP_IN:
+        {
+            int32_t &r = Reg();
+            const uint8_t port = Fetch();
+            r = port < TOTAL_INPUTS ? inputs[port] : 0;
+            break;
+        }
+
+        case OP_JMP:
+            m_pc = Fetch();
+            break;
+
+        case OP_JZ:
+        case OP_JNZ:
+        {
+            const int32_t r = Reg();
+            const uint8_t addr = Fetch();
+            if ((r == 0) == (op == OP_JZ))
+            {
+                m_pc = addr;
+            }
+            break;
+        }
+
+        case OP_JLT:
+        case OP_JGE:
+        {
+            const int32_t r = Reg();
+            const int32_t s = Reg();
+            const uint8_t addr = Fetch();
+            if ((r < s) == (op == OP_JLT))
+            {
+                m_pc = addr;
+            }
+            break;
+        }
+
+        case OP_COLOR:
+        case OP_BRIGHT:
+        {
+            const uint8_t digit = Fetch();
+            const int32_t s = Reg();
+            const uint8_t value = (op == OP_COLOR) ? (s & 0xFF) : (s < 0 ? 0 : s > 255 ? 255 : s);
+            Output(op == OP_COLOR ? wheel : brightness, digit, value);
+            break;
+        }
+
+        default: // OP_HALT, or anything that isn't an instruction
+            m_halted = true;
+            return false;
+        }
+
+        if (m_pc >= m_length)
+        {
+            m_halted = true;
+            return false;
+        }
+        return true;
+    }
+
+    void Output(uint8_t *outputs, const uint8_t digit, const uint8_t value)
+    {
+        if (digit == ALL_DIGITS)
+        {
+            for (int i = 0; i < NUM_DIGITS; ++i)
+            {
+                outputs[i] = value;
+            }
+            return;
+        }
+
+        const int32_t index = (digit & DIGIT_IN_REGISTER) ? m_registers[digit % NUM_REGISTERS] : digit;
+        if (index >= 0 && index < NUM_DIGITS)
+        {
+            outputs[index] = value;
+        }
+    }
+
+    // running off the end reads HALT
+    uint8_t Fetch()
+    {
+        return m_pc < m_length ? m_code[m_pc++] : OP_HALT;
+    }
+
+    int32_t &Reg()
+    {
+        return m_registers[Fetch() % NUM_REGISTERS];
+    }
+};
+
+// an entry in the ANIMATION_PROGRAMS table generated by tools/animasm.py
+struct AnimationProgram
+{
+    uint8_t type; // AnimationType_e
+    const uint8_t *code;
+    uint8_t length;
+    uint8_t interval; // ms between the frames it needs, 0 if only each second
+};
@@ -1,10 +1,12 @@
 #pragma once
 #include <memory>
 
+#include "animation_vm.hpp"
 #include "digit.hpp"
 #include "elapsed_time.hpp"
 #include "rtc_hal.hpp"
 #include "settings.hpp"
+#include "transitions.hpp"
 
 enum AnimationType_e
 {
@@ -20,6 +22,9 @@ enum AnimationType_e
     ANIM_SET_TIME,
 };
 
+// needs the AnimationType_e names
+#include "animation_programs.hpp"
+
 class Animator
 {
   protected:
@@ -28,6 +33,12 @@ class Animator
     DigitValues &m_values;
     uint8_t m_wheelColor;
     ElapsedTime m_timeSinceSecondBegan;
+    uint32_t m_lastFrame{0};  // millis() of the last Go()...
+    int m_lastFrameElapsed{0}; // ...and how far into its second it was
+
+    // from SETTING_TRANSITION_TYPE
+    const Transition *m_transition{nullptr};
+    bool m_subscribed{false}; // if not, it's looked up every Go()
 
   public:
     enum Configuration_e
@@ -35,6 +46,12 @@ class Animator
         // this is the amount of time that we want to spend transitioning
         // between old and new digits, in milliseconds
         TRANSITION_TIME = 400,
+
+        // time between frames while the display is moving, about 60Hz
+        FRAME_INTERVAL = 16,
+
+        // ms without the RTC's second changing before we move on anyway
+        SECOND_TIMEOUT = 1057,
     };
 
     Animator(Settings &settings, DigitValues &digitValues, const uint8_t wheelColor)
@@ -48,20 +65,56 @@ class Animator
         {
             m_values.digits[i]->AllOff();
         }
+
+        m_subscribed = m_settings.Subscribe(SettingsListener::Bind<Animator, &Animator::OnSettingsChanged>(*this));
+        if (!m_subscribed)
+        {
+            OnSettingsChanged(m_settings);
+        }
     }
 
     virtual ~Animator()
     {
+        m_settings.Unsubscribe(this);
     }
 
     void Go(const Numbers_t &numbers)
     {
+        if (!m_subscribed)
+        {
+            OnSettingsChanged(m_settings);
+        }
+
+        m_lastFrame = millis();
         CheckForSecondRollover();
+        m_lastFrameElapsed = m_timeSinceSecondBegan.Ms();
 
         DoColorChanges();
         DoBrightnessAndDisplay();
     };
 
+    // The millis() time the display next needs drawing. Until then, what
+    // Go() last drew stays the same. Subclasses that change more often
+    // than once a second override this.
+    virtual uint32_t NextFrameDue()
+    {
+        // a frame drawn mid-transition still needs the one that ends it,
+        // however late this is asked
+        if (m_lastFrameElapsed < TransitionTime())
+        {
+            return m_lastFrame + FRAME_INTERVAL;
+        }
+
+        // the RTC isn't read in Set Time mode, see CheckForSecondRollover()
+        return Earliest(NextSecondDue(), m_lastFrame + SECOND_TIMEOUT + 1 - m_lastFrameElapsed);
+    }
+
+    // whichever of two millis() times comes first, across wrap-arounds too
+    static uint32_t Earliest(const uint32_t a, const uint32_t b)
+    {
+        return (int32_t)(a - b) < 0 ? a : b;
+    }
+
     virtual void SetWheelColor(const uint8_t wheelColor)
     {
         m_wheelColor = wheelColor;
@@ -91,120 +144,75 @@ class Animator
 
     virtual void DoBrightnessAndDisplay()
     {
-        const bool isTransitioning = IsTransitioning();
+        const int elapsed = m_timeSinceSecondBegan.Ms();
+        const bool isTransitioning = elapsed < TransitionTime();
+        const uint8_t phase = isTransitioning ? elapsed * 256 / TransitionTime() : 255;
+
         for (int i = 0; i < NUM_DIGITS; ++i)
         {
-            if (m_values.lastNumbers[i] != m_values.numbers[i] && isTransitioning)
+            Digit &digit = *m_values.digits[i];
+            if (isTransitioning && ShouldTransition(i))
             {
-                float progress = TransitionProgress();
-
-                // display previous number at diminishing brightness
-                m_values.digits[i]->SetBrightness(1.0f - progress);
-                m_values.digits[i]->Display(m_values.lastNumbers[i]);
-
-                // display new number at increasing brightness, except
-                // in PXL mode where it doesn't look good to fade in
-                if (m_settings.Get(SETTING_DIGIT_TYPE) == DT_EDGE_LIT)
-                {
-                    m_values.digits[i]->SetBrightness(progress);
-                }
-                else
-                {
-                    m_values.digits[i]->SetBrightness(1.0f);
-                }
+                const bool hasLast = i < (int)m_values.lastNumbers.size();
+                const uint8_t from = hasLast ? m_values.lastNumbers[i] : m_values.numbers[i];
+                CurrentTransition().Draw(digit, from, m_values.numbers[i], phase);
             }
             else
             {
-                m_values.digits[i]->Display(Digit::INVALID);
-                m_values.digits[i]->SetBrightness(1.0f);
+                digit.AllOff();
+                digit.SetBrightness(255);
+                digit.Display(m_values.numbers[i]);
             }
-            m_values.digits[i]->Display(m_values.numbers[i]);
         }
     }
 
-  private:
-    void CheckForSecondRollover()
+    // whether a digit does the transition this second
+    virtual bool ShouldTransition(const int digit) const
     {
-        // this is to catch the case when we've stopped receiving updates from
-        // the RTC while we're in Set Time mode. if we pass sufficiently
-        // above 1000ms, we can be sure rtc_hal_second() is not functioning
-        // currently.
-        const bool oneSecondHasPassed = (m_timeSinceSecondBegan.Ms() > 1057);
-        if (rtc_hal_second() != m_lastSecond || oneSecondHasPassed)
-        {
-            m_timeSinceSecondBegan.Reset();
-            m_lastSecond = rtc_hal_second();
-            DoOncePerSecond();
-        }
+        return digit >= (int)m_values.lastNumbers.size() || m_values.lastNumbers[digit] != m_values.numbers[digit];
     }
 
-    bool IsTransitioning()
+    // in milliseconds
+    virtual int TransitionTime() const
     {
-        return m_timeSinceSecondBegan.Ms() < TRANSITION_TIME;
+        return TRANSITION_TIME;
     }
 
-    float TransitionProgress()
+    // what the digits look like on their way to the next number, as set by
+    // SETTING_TRANSITION_TYPE unless an animator has its own
+    virtual const Transition &CurrentTransition() const
     {
-        return (float)m_timeSinceSecondBegan.Ms() / TRANSITION_TIME;
+        return *m_transition;
     }
-};
-using AnimatorPtr_t = std::shared_ptr<Animator>;
 
-class AnimatorCycleColors : public Animator
-{
-    using Animator::Animator;
-
-  protected:
-    virtual void DoColorChanges()
+    // when the next second starts, by the RTC
+    uint32_t NextSecondDue() const
     {
+        return millis() + 1000 - rtc_hal_millis();
     }
 
-    virtual void DoOncePerSecond() override
+  private:
+    void OnSettingsChanged(const Settings &settings)
     {
-        for (int i = 0; i < NUM_DIGITS; ++i)
-        {
-
-            m_wheelColor += 16;
-            m_values.digits[i]->SetColor(ColorWheel(m_wheelColor));
-        }
+        m_transition = &GetTransition((TransitionType_e)settings.Get(SETTING_TRANSITION_TYPE));
     }
-};
-
-class AnimatorGlow : public Animator
-{
-    using Animator::Animator;
 
-    float m_brightness{1.0f};
-    float m_incrementer{0.1f};
-    int m_millis{0};
-
-  public:
-    virtual void DoColorChanges() override
+    void CheckForSecondRollover()
     {
-        int scaledColor = ScaleBrightness(ColorWheel(m_wheelColor), m_brightness);
-        for (int i = 0; i < NUM_DIGITS; ++i)
-        {
-            m_values.digits[i]->SetColor(scaledColor);
-        }
-
-        if ((int)millis() - m_millis >= 25)
+        // this is to catch the case when we've stopped receiving updates from
+        // the RTC while we're in Set Time mode. if we pass sufficiently
+        // above 1000ms, we can be sure rtc_hal_second() is not functioning
+        // currently.
+        const bool oneSecondHasPassed = (m_timeSinceSecondBegan.Ms() > SECOND_TIMEOUT);
+        if (rtc_hal_second() != m_lastSecond || oneSecondHasPassed)
         {
-            m_millis = millis();
-
-            m_brightness += m_incrementer;
-            if (m_brightness > 1.0f)
-            {
-                m_incrementer = -0.025f;
-                m_brightness = 1.0f;
-            }
-            else if (m_brightness < 0.4f)
-            {
-                m_incrementer = 0.025f;
-                m_brightness = 0.4f;
-            }
+            m_timeSinceSecondBegan.Reset();
+            m_lastSecond = rtc_hal_second();
+            DoOncePerSecond();
         }
     }
 };
+using AnimatorPtr_t = std::shared_ptr<Animator>;
 
 // Changes one digit color at a time, flowing to the left.
 class AnimatorCycleFlowLeft : public Animator
@@ -243,38 +251,63 @@ class AnimatorCycleFlowLeft : public Animator
     }
 };
 
-class AnimatorRainbow : public Animator
+// Runs one of the ANIMATION_PROGRAMS, see animation_vm.hpp
+class AnimatorScript : public Animator
 {
-    using Animator::Animator;
-
   private:
-    bool m_paused{false};
-    float m_colors[6] = {0, 12, 24, 36, 48, 60};
+    AnimationVm m_vm;
+    uint8_t m_colorButtonPresses{0};
+    uint8_t m_interval{0};
+    uint32_t m_lastStep{0}; // millis() of the last frame at least m_interval after the one before
 
   public:
-    virtual void DoColorChanges() override
+    AnimatorScript(Settings &settings, DigitValues &digitValues, const uint8_t wheelColor,
+                   const AnimationProgram &program)
+        : Animator(settings, digitValues, wheelColor)
     {
-        if (m_paused)
+        for (int i = 0; i < NUM_DIGITS; ++i)
         {
-            return;
+            m_vm.wheel[i] = wheelColor;
+            m_vm.brightness[i] = 255;
         }
+        m_vm.Load(program.code, program.length);
+        m_interval = program.interval;
+    }
 
-        for (int i = 5; i >= 0; --i)
-        {
-            m_colors[i] += 0.1f;
-
-            if (m_colors[i] > 255.0f)
-            {
-                m_colors[i] -= 255.0f;
-            }
+    virtual void ColorButtonPressed(uint8_t wheelColor) override
+    {
+        Animator::ColorButtonPressed(wheelColor);
+        ++m_colorButtonPresses;
+    }
 
-            m_values.digits[i]->SetColor(ColorWheel(m_colors[i]));
-        }
+    virtual uint32_t NextFrameDue() override
+    {
+        // Programs step once m_interval has passed since their last step,
+        // so time that from the last step rather than from the last frame,
+        // which can be sooner during a transition
+        const uint32_t due = Animator::NextFrameDue();
+        return m_interval ? Earliest(due, m_lastStep + m_interval) : due;
     }
 
-    virtual void ColorButtonPressed(uint8_t wheelColor) override
+  protected:
+    virtual void DoColorChanges() override
     {
-        m_paused = !m_paused;
+        m_vm.inputs[AnimationVm::IN_MILLIS] = millis();
+        m_vm.inputs[AnimationVm::IN_MS] = m_timeSinceSecondBegan.Ms();
+        m_vm.inputs[AnimationVm::IN_SECOND] = m_lastSecond;
+        m_vm.inputs[AnimationVm::IN_WHEEL] = m_wheelColor;
+        m_vm.inputs[AnimationVm::IN_BUTTON] = m_colorButtonPresses;
+        m_vm.RunFrame();
+
+        if (m_lastFrame - m_lastStep >= m_interval)
+        {
+            m_lastStep = m_lastFrame;
+        }
+
+        for (int i = 0; i < NUM_DIGITS; ++i)
+        {
+            m_values.digits[i]->SetColor(ColorScale(ColorWheel(m_vm.wheel[i]), m_vm.brightness[i]));
+        }
     }
 };
 
@@ -288,8 +321,6 @@ class AnimatorZippy : public Animator
         ZIPPY_TIME = 250,
     };
 
-    float m_zippy{0};
-
   public:
     virtual void DoColorChanges() override
     {
@@ -299,35 +330,25 @@ class AnimatorZippy : public Animator
         }
     }
 
-    virtual void DoBrightnessAndDisplay()
+  protected:
+    // every digit goes through the transition at the start of each minute,
+    // not just the ones that changed
+    virtual bool ShouldTransition(const int digit) const override
     {
-        const float ms = m_timeSinceSecondBegan.Ms();
-
-        bool isBeginningOfMinute = rtc_hal_second() == 00; // octal zero for funsies
-        float zippyTime = ZIPPY_TIME;
-
-        bool isZippy = ms < zippyTime;
-        for (int i = 0; i < NUM_DIGITS; ++i)
-        {
-            if (m_values.lastNumbers[i] != m_values.numbers[i] && isZippy || isBeginningOfMinute && isZippy)
-            {
-                int zippy = m_values.lastNumbers[i];
-                zippy += (ms / zippyTime) * 10;
+        return rtc_hal_second() == 00 || Animator::ShouldTransition(digit); // octal zero for funsies
+    }
 
-                if (zippy > 9)
-                {
-                    zippy -= 10;
-                }
+    virtual int TransitionTime() const override
+    {
+        return ZIPPY_TIME;
+    }
 
-                m_values.digits[i]->AllOff();
-                m_values.digits[i]->Display(zippy);
-            }
-            else
-            {
-                m_values.digits[i]->AllOff();
-                m_values.digits[i]->Display(m_values.numbers[i]);
-            }
-        }
+    // rolling through the numbers is what makes it zippy, whatever the
+    // transition setting and the kind of digits
+    virtual const Transition &CurrentTransition() const override
+    {
+        static const TransitionCount count;
+        return count;
     }
 };
 
@@ -341,7 +362,7 @@ class AnimatorAltDisplay : public Animator
         for (int i = 0; i < NUM_DIGITS; ++i)
         {
             m_values.digits[i]->AllOff();
-            m_values.digits[i]->SetBrightness(1.0f);
+            m_values.digits[i]->SetBrightness(255);
             m_values.digits[i]->SetColor(ColorWheel(m_wheelColor + 128));
             m_values.digits[i]->Display(m_values.numbers[i]);
         }
@@ -353,18 +374,25 @@ class AnimatorSetTime : public Animator
     using Animator::Animator;
 
   public:
+    // the hours and minutes dim halfway through each second
+    virtual uint32_t NextFrameDue() override
+    {
+        const uint32_t due = Animator::NextFrameDue();
+        return m_lastFrameElapsed <= 500 ? Earliest(due, m_lastFrame + 501 - m_lastFrameElapsed) : due;
+    }
+
     virtual void DoBrightnessAndDisplay() override
     {
         for (int i = 0; i < NUM_DIGITS; ++i)
         {
             m_values.digits[i]->AllOff();
 
-            m_values.digits[i]->SetBrightness(1.0f);
+            m_values.digits[i]->SetBrightness(255);
             if (i < DIGIT_5)
             {
                 if (m_timeSinceSecondBegan.Ms() > 500)
                 {
-                    m_values.digits[i]->SetBrightness(0.8f);
+                    m_values.digits[i]->SetBrightness(204);
                 }
 
                 m_values.digits[i]->SetColor(ColorWheel(m_wheelColor + 128));
@@ -382,16 +410,18 @@ class AnimatorSetTime : public Animator
 static inline std::shared_ptr<Animator> AnimatorFactory(Settings &settings, DigitValues &digitValues,
                                                         const AnimationType_e type, uint8_t wheelColor)
 {
+    for (const AnimationProgram &program : ANIMATION_PROGRAMS)
+    {
+        if (program.type == type)
+        {
+            return std::make_shared<AnimatorScript>(settings, digitValues, wheelColor, program);
+        }
+    }
+
     switch (type)
     {
-    case ANIM_GLOW:
-        return std::make_shared<AnimatorGlow>(settings, digitValues, wheelColor);
-    case ANIM_CYCLE_COLORS:
-        return std::make_shared<AnimatorCycleColors>(settings, digitValues, wheelColor);
     case ANIM_CYCLE_FLOW_LEFT:
         return std::make_shared<AnimatorCycleFlowLeft>(settings, digitValues, wheelColor);
-    case ANIM_RAINBOW:
-        return std::make_shared<AnimatorRainbow>(settings, digitValues, wheelColor);
     case ANIM_ZIPPY:
         return std::make_shared<AnimatorZippy>(settings, digitValues, wheelColor);
     case ANIM_ALT_DISPLAY:
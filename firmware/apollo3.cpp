@@ -4,6 +4,7 @@
 
 #include <ap3_types.h>
 #include <am_hal_gpio.h>
+#include <am_mcu_apollo.h>
 
 #include "Adafruit_NeoPixel.h"
 
@@ -11,6 +12,91 @@
 // TODO: Implement something better (interrupts, DMA, etc)
 #define PIN_METHOD_FAST_GPIO
 
+// Longest the data line may sit low between pixels while interrupts run.
+// WS2812s latch after 50 microseconds of low (280 on newer parts), so this
+// leaves a good margin.
+#define NEO_MAX_GAP_US  20
+// Low time after which the LEDs have certainly latched
+#define NEO_LATCH_US   300
+// Frames started over in a row before sending with interrupts off instead
+#define NEO_MAX_RESENDS  2
+
+// Bit timings in nanoseconds: the time high for a 0 and for a 1, and the
+// whole bit. 800 KHz is the WS2812B, 400 KHz the WS2811 in its slow mode.
+// Both allow 150ns either way on the high times. The low time after a bit
+// can stretch much more, which is where the next byte gets fetched.
+#define NEO_800_T0H      400
+#define NEO_800_T1H      800
+#define NEO_800_BIT     1250
+#define NEO_400_T0H      500
+#define NEO_400_T1H     1200
+#define NEO_400_BIT     2500
+#define NEO_TOLERANCE_NS 150
+
+// Cycles the bit loops take besides their delays. These are counted by hand
+// from the instruction timings in the Cortex-M4 Technical Reference Manual,
+// for the Thumb-2 instructions the loops compile to, and not measured:
+//   TEST  tst p, bitMask (1), then the branch on the bit (1 not taken, 1 + 1-3
+//         to refill the pipeline when taken), taken as 2
+//   LOOP  the clear and the set, a store each (1 + 1), lsrs bitMask (1), the
+//         branch on it not taken (1), and the branch back to the top
+//         (1 + 3, the worst case refill)
+// A taken branch's refill depends on where its target falls in the fetch
+// buffer, so the real counts can be a cycle or so off. show() checks them
+// against the cycle counter on every frame, see getBitLoopError(). The
+// time for a fast GPIO write to reach the pad is the same for set and clear,
+// so it cancels out.
+#define NEO_CYCLES_TEST  3 // test the bit and branch, before the clear
+#define NEO_CYCLES_LOOP  8 // clear, shift the mask, loop back, set
+
+#define NEO_NS_TO_CYCLES(ns) (((ns) * NEO_CYCLES_PER_US + 500) / 1000)
+#define NEO_CYCLES_TO_NS(c)  ((c) * 1000 / NEO_CYCLES_PER_US)
+
+// The three delays in each bit: after the set until the bit is tested,
+// then the extra for a 1, and after the clear until the next bit
+#define NEO_DELAY_HIGH(t0h)     (NEO_NS_TO_CYCLES(t0h) - NEO_CYCLES_TEST)
+#define NEO_DELAY_ONE(t0h, t1h) (NEO_NS_TO_CYCLES(t1h) - NEO_NS_TO_CYCLES(t0h))
+#define NEO_DELAY_LOW(t1h, bit) (NEO_NS_TO_CYCLES(bit) - NEO_NS_TO_CYCLES(t1h) - NEO_CYCLES_LOOP)
+
+#define NEO_800_HIGH NEO_DELAY_HIGH(NEO_800_T0H)
+#define NEO_800_ONE  NEO_DELAY_ONE(NEO_800_T0H, NEO_800_T1H)
+#define NEO_800_LOW  NEO_DELAY_LOW(NEO_800_T1H, NEO_800_BIT)
+#define NEO_400_HIGH NEO_DELAY_HIGH(NEO_400_T0H)
+#define NEO_400_ONE  NEO_DELAY_ONE(NEO_400_T0H, NEO_400_T1H)
+#define NEO_400_LOW  NEO_DELAY_LOW(NEO_400_T1H, NEO_400_BIT)
+
+// Cycles from the start of a frame until its first byte has been sent: all
+// eight bits but for the last one's low delay and loop back, which the first
+// cycle counter read and set make up for
+#define NEO_800_BYTE (8 * NEO_NS_TO_CYCLES(NEO_800_BIT) - NEO_800_LOW)
+#define NEO_400_BYTE (8 * NEO_NS_TO_CYCLES(NEO_400_BIT) - NEO_400_LOW)
+
+// True if the cycles come out within tolerance of the time in ns
+#define NEO_WITHIN(c, ns) \
+  ((NEO_CYCLES_TO_NS(c) + NEO_TOLERANCE_NS >= (ns)) && \
+   (NEO_CYCLES_TO_NS(c) <= (ns) + NEO_TOLERANCE_NS))
+
+static_assert((NEO_800_HIGH >= 0) && (NEO_800_ONE >= 0) && (NEO_800_LOW >= 0),
+  "CPU clock too slow for 800 KHz NeoPixels");
+static_assert(NEO_WITHIN(NEO_800_HIGH + NEO_CYCLES_TEST, NEO_800_T0H) &&
+  NEO_WITHIN(NEO_800_HIGH + NEO_CYCLES_TEST + NEO_800_ONE, NEO_800_T1H),
+  "800 KHz high times out of tolerance");
+static_assert(NEO_800_HIGH + NEO_CYCLES_TEST + NEO_800_ONE + NEO_CYCLES_LOOP +
+  NEO_800_LOW == NEO_NS_TO_CYCLES(NEO_800_BIT), "800 KHz bit period is off");
+static_assert((NEO_400_HIGH >= 0) && (NEO_400_ONE >= 0) && (NEO_400_LOW >= 0),
+  "CPU clock too slow for 400 KHz NeoPixels");
+static_assert(NEO_WITHIN(NEO_400_HIGH + NEO_CYCLES_TEST, NEO_400_T0H) &&
+  NEO_WITHIN(NEO_400_HIGH + NEO_CYCLES_TEST + NEO_400_ONE, NEO_400_T1H),
+  "400 KHz high times out of tolerance");
+static_assert(NEO_400_HIGH + NEO_CYCLES_TEST + NEO_400_ONE + NEO_CYCLES_LOOP +
+  NEO_400_LOW == NEO_NS_TO_CYCLES(NEO_400_BIT), "400 KHz bit period is off");
+
+// Wait a fixed number of cycles, one nop each. The host tests define their
+// own, which moves their cycle counter on instead.
+#ifndef NEO_DELAY
+#define NEO_DELAY(cycles) asm volatile(".rept %c0\n\tnop\n\t.endr" :: "i"(cycles))
+#endif
+
 /*!
   @brief   Unset the NeoPixel output pad number.
   @param   pad  Apollo3 pad number
@@ -43,94 +129,198 @@ void Adafruit_NeoPixel::apollo3SetPad(ap3_gpio_pad_t pad) {
 #endif
 }
 
-// Note - The timings used below are based on the Arduino Zero,
-//   Gemma/Trinket M0 code.
+/*!
+  @brief   Fetch the next byte to send, scaled by the brightness. In
+           indexed mode, pixels holds palette indices and each one is
+           looked up as its first byte is needed. This runs between bits,
+           where the low time can stretch a little without the LEDs
+           noticing.
+  @return  false when everything has been sent.
+*/
+static inline __attribute__((always_inline)) boolean apollo3NextByte(
+  uint8_t *&ptr, uint8_t *end, const uint8_t *palette, uint16_t scale,
+  const uint8_t *&color, uint8_t &channelsLeft, uint8_t &p) {
+
+  uint8_t raw;
+  if(channelsLeft) { // Rest of the current indexed pixel
+    channelsLeft--;
+    raw = *color++;
+  } else {
+    if(ptr >= end) return false;
+    if(palette) {
+      color        = palette + 3 * *ptr++;
+      raw          = *color++;
+      channelsLeft = 2;
+    } else {
+      raw = *ptr++;
+    }
+  }
+  p = (raw * scale) >> 8;
+  return true;
+}
+
+/*!
+  @brief   Compare the time the first byte of a frame took with what the
+           cycle counts above expect, see getBitLoopError(). This runs
+           between bits, so it can only stretch a low time.
+  @param   offStart  Cycle count when the frame started.
+  @param   expected  NEO_800_BYTE or NEO_400_BYTE.
+  @param   error     Set to the cycles it took beyond that.
+*/
+static inline __attribute__((always_inline)) void apollo3CheckByte(
+  uint32_t offStart, int32_t expected, int16_t &error) {
+
+  error = (int16_t)((int32_t)(DWT->CYCCNT - offStart) - expected);
+}
+
+/*!
+  @brief   Close an interrupts-off window, let any pending interrupts run,
+           and open the next one. This runs between pixels, with the data
+           line low.
+  @param   irqState  Interrupt state from before show() turned them off.
+  @param   offStart  Cycle count when the window opened, updated to when
+                     the next one did.
+  @param   maxOff    Longest window so far, in cycles.
+  @return  false if the interrupts took so long that the LEDs may have
+           latched part of the frame.
+*/
+static inline __attribute__((always_inline)) boolean apollo3Breathe(
+  uint32_t irqState, uint32_t &offStart, uint32_t &maxOff) {
+
+  uint32_t now = DWT->CYCCNT;
+  if(now - offStart > maxOff) maxOff = now - offStart;
+  am_hal_interrupt_master_set(irqState);
+  am_hal_interrupt_master_disable();
+  offStart = DWT->CYCCNT;
+  return (offStart - now) <= NEO_MAX_GAP_US * NEO_CYCLES_PER_US;
+}
 
 /*!
-  @brief   Transmit pixel data in RAM to NeoPixels.
-  @note    The current design is a quick hack and should be replaced with
-           a more robust timing mechanism.
+  @brief   Transmit pixel data in RAM to NeoPixels. Interrupts are off
+           while sending, either for the whole frame or, with
+           setInterruptGroup(), for a few pixels at a time.
+  @param   palette  NULL, or in indexed mode the palette, 3 bytes per entry
+                    in wire order, that the bytes in pixels index.
+  @param   scale    Brightness, 1 (off) to 256 (as stored).
+  @note    The delays are nop counts worked out from the core clock and
+           the LED timings above, so the loops below must keep the shape
+           NEO_CYCLES_TEST and NEO_CYCLES_LOOP were counted from.
 */
 void Adafruit_NeoPixel::apollo3Show(
-  ap3_gpio_pad_t pad, uint8_t *pixels, uint32_t numBytes, boolean is800KHz) {
+  ap3_gpio_pad_t pad, uint8_t *pixels, uint32_t numBytes, boolean is800KHz,
+  const uint8_t *palette, uint16_t scale) {
+
+  uint8_t  *ptr, *end, p, bitMask, channelsLeft;
+  const uint8_t *color;
+  uint32_t  groupBytes, bytesLeft, irqState, offStart;
+  uint8_t   tries = 0;
+  boolean   resend, firstByte;
+
+  // Bytes sent between interrupt windows. A whole frame never gets to its
+  // window, since the last byte ends the loop first.
+  groupBytes = irqGroup ? irqGroup * ((wOffset == rOffset) ? 3 : 4) : numBytes;
 
-  uint8_t  *ptr, *end, p, bitMask;
-  ptr     =  pixels;
-  end     =  ptr + numBytes;
-  p       = *ptr++;
-  bitMask =  0x80;
+  // The cycle counter times the interrupts-off windows
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CTRL        |= DWT_CTRL_CYCCNTENA_Msk;
+
+  do {
+    ptr          =  pixels;
+    end          =  ptr + (palette ? numBytes / 3 : numBytes);
+    channelsLeft =  0;
+    color        =  NULL;
+    if(!apollo3NextByte(ptr, end, palette, scale, color, channelsLeft, p)) return;
+    bitMask      =  0x80;
+    bytesLeft    =  groupBytes;
+    resend       =  false;
+    firstByte    =  true;
 
 #if defined(PIN_METHOD_FAST_GPIO)
 
-  // disable interrupts
-  am_hal_interrupt_master_disable();
+    // disable interrupts
+    irqState = am_hal_interrupt_master_disable();
+    offStart = DWT->CYCCNT;
 
 #ifdef NEO_KHZ400 // 800 KHz check needed only if 400 KHz support enabled
-  if(is800KHz) {
+    if(is800KHz) {
 #endif
-    for(;;) {
-      am_hal_gpio_fastgpio_set(pad);
-      //asm("nop; nop; nop; nop; nop; nop; nop; nop;");
-      asm("nop; nop; nop; nop; nop; nop; nop; nop; nop; nop; nop; nop;");
-      if(p & bitMask) {
-        asm("nop; nop; nop; nop; nop; nop; nop; nop;"
-            "nop; nop; nop; nop; nop; nop; nop; nop;"
-            "nop; nop; nop; nop;");
-        am_hal_gpio_fastgpio_clr(pad);
-      } else {
-        am_hal_gpio_fastgpio_clr(pad);
-        asm("nop; nop; nop; nop; nop; nop; nop; nop;"
-            "nop; nop; nop; nop; nop; nop; nop; nop;"
-            "nop; nop; nop; nop;");
-      }
-      if(bitMask >>= 1) {
-	asm("nop; nop; nop; nop; nop; nop; nop; nop; nop;");
-      } else {
-        if(ptr >= end) break;
-        p       = *ptr++;
-        bitMask = 0x80;
+      for(;;) {
+        am_hal_gpio_fastgpio_set(pad);
+        NEO_DELAY(NEO_800_HIGH);
+        if(p & bitMask) {
+          NEO_DELAY(NEO_800_ONE);
+          am_hal_gpio_fastgpio_clr(pad);
+        } else {
+          am_hal_gpio_fastgpio_clr(pad);
+          NEO_DELAY(NEO_800_ONE);
+        }
+        if(bitMask >>= 1) {
+          NEO_DELAY(NEO_800_LOW);
+        } else {
+          if(firstByte) {
+            apollo3CheckByte(offStart, NEO_800_BYTE, bitLoopError);
+            firstByte = false;
+          }
+          if(!apollo3NextByte(ptr, end, palette, scale, color, channelsLeft, p)) break;
+          bitMask = 0x80;
+          if(!--bytesLeft) {
+            bytesLeft = groupBytes;
+            if(!apollo3Breathe(irqState, offStart, irqOffMax)) {
+              resend = true;
+              break;
+            }
+          }
+        }
       }
-    }
 #ifdef NEO_KHZ400
-  } else { // 400 KHz bitstream
-    // NOTE - These timings may need to be tweaked
-    for(;;) {
-      am_hal_gpio_fastgpio_set(pad);
-      asm("nop;");
-      if(p & bitMask) {
-        asm("nop; nop; nop; nop; nop; nop; nop; nop;"
-            "nop; nop; nop; nop; nop; nop; nop; nop;"
-            "nop; nop; nop; nop; nop; nop; nop; nop;"
-            "nop; nop; nop;");
-        am_hal_gpio_fastgpio_clr(pad);
-      } else {
-        am_hal_gpio_fastgpio_clr(pad);
-        asm("nop; nop; nop; nop; nop; nop; nop; nop;"
-            "nop; nop; nop; nop; nop; nop; nop; nop;"
-            "nop; nop; nop; nop; nop; nop; nop; nop;"
-            "nop; nop; nop;");
-      }
-      asm("nop; nop; nop; nop; nop; nop; nop; nop;"
-          "nop; nop; nop; nop; nop; nop; nop; nop;"
-          "nop; nop; nop; nop; nop; nop; nop; nop;"
-          "nop; nop; nop; nop; nop; nop; nop; nop;"
-          "nop; nop; nop; nop; nop; nop; nop; nop;"
-          "nop; nop; nop; nop; nop; nop; nop; nop;");
-      if(bitMask >>= 1) {
-        asm("nop; nop; nop; nop; nop; nop; nop;");
-      } else {
-        if(ptr >= end) break;
-        p       = *ptr++;
-        bitMask = 0x80;
+    } else { // 400 KHz bitstream
+      for(;;) {
+        am_hal_gpio_fastgpio_set(pad);
+        NEO_DELAY(NEO_400_HIGH);
+        if(p & bitMask) {
+          NEO_DELAY(NEO_400_ONE);
+          am_hal_gpio_fastgpio_clr(pad);
+        } else {
+          am_hal_gpio_fastgpio_clr(pad);
+          NEO_DELAY(NEO_400_ONE);
+        }
+        if(bitMask >>= 1) {
+          NEO_DELAY(NEO_400_LOW);
+        } else {
+          if(firstByte) {
+            apollo3CheckByte(offStart, NEO_400_BYTE, bitLoopError);
+            firstByte = false;
+          }
+          if(!apollo3NextByte(ptr, end, palette, scale, color, channelsLeft, p)) break;
+          bitMask = 0x80;
+          if(!--bytesLeft) {
+            bytesLeft = groupBytes;
+            if(!apollo3Breathe(irqState, offStart, irqOffMax)) {
+              resend = true;
+              break;
+            }
+          }
+        }
       }
     }
-  }
+#endif // NEO_KHZ400
 
-  // re-enable interrupts
-  am_hal_interrupt_master_enable();
+    // re-enable interrupts
+    offStart = DWT->CYCCNT - offStart;
+    if(offStart > irqOffMax) irqOffMax = offStart;
+    am_hal_interrupt_master_set(irqState);
 
-#endif // NEO_KHZ400
 #endif // PIN_METHOD_FAST_GPIO
+
+    if(resend) {
+      // Let the LEDs latch whatever they got and start over. If interrupts
+      // keep getting in the way, the last try sends without them.
+      resends++;
+      if(++tries >= NEO_MAX_RESENDS) groupBytes = numBytes;
+      offStart = DWT->CYCCNT;
+      while(DWT->CYCCNT - offStart < NEO_LATCH_US * NEO_CYCLES_PER_US);
+    }
+  } while(resend);
 }
 
 #endif // AM_PART_APOLLO3
@@ -1,5 +1,5 @@
 #pragma once
-#include "Adafruit_NeoPixel.h"
+#include "compositor.hpp"
 #include "digit.hpp"
 #include "rtc_hal.hpp"
 #include "settings.hpp"
@@ -19,17 +19,30 @@ class Blinkers
         BLINK_DIGIT_TYPE_2_LED_3 = 65,
         BLINK_DIGIT_TYPE_2_LED_4 = 73,
     };
-    Adafruit_NeoPixel &m_leds;
+    Layer &m_layer;
     Settings &m_settings;
 
+    // derived from the settings whenever they change
+    bool m_enabled{false};
+    uint8_t m_digitType{DT_EDGE_LIT};
+    uint32_t m_blinkColor{0};
+    bool m_subscribed{false}; // if not, they're derived every Update()
+
   public:
-    Blinkers(Adafruit_NeoPixel &leds, Settings &settings) : m_leds(leds), m_settings(settings)
+    Blinkers(Compositor &compositor, Settings &settings)
+        : m_layer(compositor.GetLayer(LAYER_SEPARATORS)), m_settings(settings)
     {
+        m_subscribed = m_settings.Subscribe(SettingsListener::Bind<Blinkers, &Blinkers::OnSettingsChanged>(*this));
     }
 
     void Update()
     {
-        if (rtc_hal_second() % 2 != 0 && m_settings.Get(SETTING_BLINKING_SEPARATORS))
+        if (!m_subscribed)
+        {
+            OnSettingsChanged(m_settings);
+        }
+
+        if (rtc_hal_second() % 2 != 0 && m_enabled)
         {
             TurnOnBlinkers();
         }
@@ -41,34 +54,30 @@ class Blinkers
 
     void TurnOnBlinkers()
     {
-        const int blinkColor = ColorWheel(m_settings.Get(SETTING_COLOR));
-        if (m_settings.Get(SETTING_DIGIT_TYPE) == DT_EDGE_LIT)
+        if (m_digitType == DT_EDGE_LIT)
         {
-            m_leds.setPixelColor(BLINK_DIGIT_TYPE_1_LED_1, blinkColor);
-            m_leds.setPixelColor(BLINK_DIGIT_TYPE_1_LED_2, blinkColor);
+            m_layer.SetPixel(BLINK_DIGIT_TYPE_1_LED_1, m_blinkColor);
+            m_layer.SetPixel(BLINK_DIGIT_TYPE_1_LED_2, m_blinkColor);
         }
-        else if (m_settings.Get(SETTING_DIGIT_TYPE) == DT_PIXELS)
+        else if (m_digitType == DT_PIXELS)
         {
-            m_leds.setPixelColor(BLINK_DIGIT_TYPE_2_LED_1, blinkColor);
-            m_leds.setPixelColor(BLINK_DIGIT_TYPE_2_LED_2, blinkColor);
-            m_leds.setPixelColor(BLINK_DIGIT_TYPE_2_LED_3, blinkColor);
-            m_leds.setPixelColor(BLINK_DIGIT_TYPE_2_LED_4, blinkColor);
+            m_layer.SetPixel(BLINK_DIGIT_TYPE_2_LED_1, m_blinkColor);
+            m_layer.SetPixel(BLINK_DIGIT_TYPE_2_LED_2, m_blinkColor);
+            m_layer.SetPixel(BLINK_DIGIT_TYPE_2_LED_3, m_blinkColor);
+            m_layer.SetPixel(BLINK_DIGIT_TYPE_2_LED_4, m_blinkColor);
         }
     }
 
     void TurnOffBlinkers()
     {
-        if (m_settings.Get(SETTING_DIGIT_TYPE) == DT_EDGE_LIT)
-        {
-            m_leds.setPixelColor(BLINK_DIGIT_TYPE_1_LED_1, 0);
-            m_leds.setPixelColor(BLINK_DIGIT_TYPE_1_LED_2, 0);
-        }
-        else
-        {
-            m_leds.setPixelColor(BLINK_DIGIT_TYPE_2_LED_1, 0);
-            m_leds.setPixelColor(BLINK_DIGIT_TYPE_2_LED_2, 0);
-            m_leds.setPixelColor(BLINK_DIGIT_TYPE_2_LED_3, 0);
-            m_leds.setPixelColor(BLINK_DIGIT_TYPE_2_LED_4, 0);
-        }
+        m_layer.Clear();
+    }
+
+  private:
+    void OnSettingsChanged(const Settings &settings)
+    {
+        m_enabled = settings.Get(SETTING_BLINKING_SEPARATORS);
+        m_digitType = settings.Get(SETTING_DIGIT_TYPE);
+        m_blinkColor = ColorWheel(settings.Get(SETTING_COLOR));
     }
 };
@@ -0,0 +1,225 @@
+#pragma once
+#include <atomic>
+
+// One bit per physical button, used for masks of pressed buttons
+enum ButtonBits_e
+{
+    BTN_BIT_H = 1 << 0,
+    BTN_BIT_M = 1 << 1,
+    BTN_BIT_C = 1 << 2,
+    BTN_BIT_B = 1 << 3,
+
+    BTN_BITS_ALL = BTN_BIT_H | BTN_BIT_M | BTN_BIT_C | BTN_BIT_B,
+};
+
+static inline uint8_t ButtonBit(const Pins_e pin)
+{
+    switch (pin)
+    {
+    case PIN_BTN_H:
+        return BTN_BIT_H;
+    case PIN_BTN_M:
+        return BTN_BIT_M;
+    case PIN_BTN_C:
+        return BTN_BIT_C;
+    case PIN_BTN_B:
+        return BTN_BIT_B;
+    }
+    return 0;
+}
+
+struct ButtonEdge
+{
+    uint32_t timestamp; // micros() when the edge happened
+    uint8_t bit;        // which button, see ButtonBits_e
+    bool pressed;       // pin level right after the edge
+};
+
+// Lock-free ring buffer with a single producer (the GPIO interrupt) and a
+// single consumer (the main loop). Each side only ever writes its own index,
+// and the release/acquire pair makes sure an edge is completely written
+// before the consumer can see it.
+class ButtonEdgeQueue
+{
+  private:
+    enum
+    {
+        QUEUE_SIZE = 32, // must be a power of 2
+    };
+
+    ButtonEdge m_edges[QUEUE_SIZE];
+    std::atomic<uint8_t> m_head{0}; // written by producer only
+    std::atomic<uint8_t> m_tail{0}; // written by consumer only
+
+  public:
+    bool Push(const ButtonEdge &edge)
+    {
+        const uint8_t head = m_head.load(std::memory_order_relaxed);
+        if ((uint8_t)(head - m_tail.load(std::memory_order_acquire)) >= QUEUE_SIZE)
+        {
+            return false; // full
+        }
+
+        m_edges[head % QUEUE_SIZE] = edge;
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool Pop(ButtonEdge &edge)
+    {
+        const uint8_t tail = m_tail.load(std::memory_order_relaxed);
+        if (tail == m_head.load(std::memory_order_acquire))
+        {
+            return false; // empty
+        }
+
+        edge = m_edges[tail % QUEUE_SIZE];
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool IsEmpty() const
+    {
+        return m_tail.load(std::memory_order_relaxed) == m_head.load(std::memory_order_acquire);
+    }
+};
+
+// Watches all of the button pins with edge interrupts, so the main loop only
+// has to do work when a button actually changes state. While anything is
+// happening, the pins are sampled once per loop into a single snapshot that
+// every Button works from.
+class ButtonInput
+{
+  private:
+    ButtonEdgeQueue m_queue;
+    std::atomic<bool> m_overflowed{false};
+    uint8_t m_pressed{0};
+    uint32_t m_firstEdgeTime{0};
+
+  public:
+    ButtonInput()
+    {
+        Instance() = this;
+
+        AttachPin(PIN_BTN_H, IsrH);
+        AttachPin(PIN_BTN_M, IsrM);
+        AttachPin(PIN_BTN_C, IsrC);
+        AttachPin(PIN_BTN_B, IsrB);
+
+        m_pressed = ReadAllPins();
+    }
+
+    ~ButtonInput()
+    {
+        detachInterrupt(digitalPinToInterrupt(PIN_BTN_H));
+        detachInterrupt(digitalPinToInterrupt(PIN_BTN_M));
+        detachInterrupt(digitalPinToInterrupt(PIN_BTN_C));
+        detachInterrupt(digitalPinToInterrupt(PIN_BTN_B));
+        Instance() = nullptr;
+    }
+
+    // Call once per loop. Returns the mask of currently pressed buttons and
+    // sets hadEdges if anything changed since the last call.
+    uint8_t Sample(bool &hadEdges)
+    {
+        hadEdges = false;
+
+        ButtonEdge edge;
+        while (m_queue.Pop(edge))
+        {
+            if (!hadEdges)
+            {
+                m_firstEdgeTime = edge.timestamp;
+            }
+            hadEdges = true;
+            m_pressed = edge.pressed ? (m_pressed | edge.bit) : (m_pressed & ~edge.bit);
+        }
+
+        // When idle, the edges are all we need. Otherwise read the pins once
+        // for this loop, which also catches the final state of a bouncing
+        // button if its last edge was missed or the queue overflowed.
+        const bool overflowed = m_overflowed.exchange(false);
+        if (hadEdges || overflowed || m_pressed != 0)
+        {
+            hadEdges = hadEdges || overflowed;
+            m_pressed = ReadAllPins();
+        }
+
+        return m_pressed;
+    }
+
+    // true if edges arrived since the last Sample()
+    bool HasEdges() const
+    {
+        return !m_queue.IsEmpty() || m_overflowed;
+    }
+
+    // micros() time of the earliest edge in the last batch Sample() took
+    // from the queue
+    uint32_t FirstEdgeTime() const
+    {
+        return m_firstEdgeTime;
+    }
+
+  private:
+    void OnEdge(const Pins_e pin)
+    {
+        const ButtonEdge edge = {(uint32_t)micros(), ButtonBit(pin), digitalRead(pin) == 0};
+        if (!m_queue.Push(edge))
+        {
+            m_overflowed = true;
+        }
+    }
+
+    static uint8_t ReadAllPins()
+    {
+        uint8_t pressed = 0;
+        pressed |= (digitalRead(PIN_BTN_H) == 0) ? BTN_BIT_H : 0;
+        pressed |= (digitalRead(PIN_BTN_M) == 0) ? BTN_BIT_M : 0;
+        pressed |= (digitalRead(PIN_BTN_C) == 0) ? BTN_BIT_C : 0;
+        pressed |= (digitalRead(PIN_BTN_B) == 0) ? BTN_BIT_B : 0;
+        return pressed;
+    }
+
+    static void AttachPin(const Pins_e pin, void (*isr)())
+    {
+        pinMode(pin, INPUT_PULLUP);
+        attachInterrupt(digitalPinToInterrupt(pin), isr, CHANGE);
+    }
+
+    // interrupt handlers can't be bound to an object, so they find the one
+    // ButtonInput through this pointer
+    static ButtonInput *&Instance()
+    {
+        static ButtonInput *instance = nullptr;
+        return instance;
+    }
+
+    static void Dispatch(ButtonInput *input, const Pins_e pin)
+    {
+        if (input)
+        {
+            input->OnEdge(pin);
+        }
+    }
+
+    static void IsrH()
+    {
+        Dispatch(Instance(), PIN_BTN_H);
+    }
+
+    static void IsrM()
+    {
+        Dispatch(Instance(), PIN_BTN_M);
+    }
+
+    static void IsrC()
+    {
+        Dispatch(Instance(), PIN_BTN_C);
+    }
+
+    static void IsrB()
+    {
+        Dispatch(Instance(), PIN_BTN_B);
+    }
+};
@@ -3,12 +3,17 @@
 
 #include "animator.hpp"
 #include "blinkers.hpp"
-#include "button.hpp"
+#include "button_input.hpp"
+#include "compositor.hpp"
 #include "digit_manager.hpp"
 #include "elapsed_time.hpp"
+#include "gestures.hpp"
+#include "latency_trace.hpp"
+#include "power_manager.hpp"
 #include "reversible_neopixels.hpp"
 #include "rtc_hal.hpp"
 #include "settings.hpp"
+#include "stats.hpp"
 
 class Clock
 {
@@ -20,24 +25,63 @@ class Clock
         STATE_ALT_DISPLAY,
     };
 
+    enum ClockStateBits_e
+    {
+        IN_NORMAL = 1 << STATE_NORMAL,
+        IN_SET_TIME = 1 << STATE_SET_TIME,
+        IN_ALT_DISPLAY = 1 << STATE_ALT_DISPLAY,
+
+        // the alternate display is only shown briefly, so buttons work
+        // the same as in normal mode while it is up
+        IN_ANY_NORMAL = IN_NORMAL | IN_ALT_DISPLAY,
+        IN_ANY = IN_ANY_NORMAL | IN_SET_TIME,
+    };
+
+    enum
+    {
+        // with FOXIE_INDEXED_PIXELS, the most colors on the LEDs at once. A
+        // different color per digit, all mid-transition, comes to 17.
+        PALETTE_SIZE = 32,
+
+        // LEDs sent at a time with interrupts off, so buttons and Serial
+        // don't have to wait for the whole frame. At 800kHz it's 30us each.
+        LED_INTERRUPT_GROUP = 1,
+
+        // ms the alternate display stays up
+        ALT_DISPLAY_TIME = 1000,
+    };
+
+    enum ButtonAction_e
+    {
+        ACTION_TOGGLE_SET_TIME,
+        ACTION_HOUR_UP,
+        ACTION_MINUTE_UP,
+        ACTION_NEXT_ANIMATION,
+        ACTION_NEXT_COLOR,
+        ACTION_SAVE_COLOR,
+        ACTION_NEXT_BRIGHTNESS,
+        ACTION_INCREASE_BRIGHTNESS,
+        ACTION_TOGGLE_24H_MODE,
+        ACTION_TOGGLE_DISPLAY_TYPE,
+        ACTION_TOGGLE_BLINKERS,
+        ACTION_FLIP_DISPLAY,
+        ACTION_NEXT_TRANSITION,
+    };
+
     Settings m_settings;
-    ReversibleNeopixels m_leds{m_settings, NUM_LEDS, PIN_FOR_LEDS, NEO_GRB + NEO_KHZ400};
-    DigitManager m_digitMgr{m_leds, m_settings};
-    Blinkers m_blinkers{m_leds, m_settings};
+    ReversibleNeopixels m_leds{m_settings, NUM_LEDS, PIN_FOR_LEDS, NEO_GRB + NEO_KHZ800};
+    Compositor m_compositor;
+    DigitManager m_digitMgr{m_compositor, m_settings};
+    Blinkers m_blinkers{m_compositor, m_settings};
     ClockState_e m_state{STATE_NORMAL};
 
-    Button m_btnSetTime{PIN_BTN_H};
-    Button m_btnHour{PIN_BTN_H};
-    Button m_btnMinute{PIN_BTN_M};
-    Button m_btnAnimationMode{PIN_BTN_M};
-    Button m_btnColor{PIN_BTN_C};
-    Button m_btnBrightness{PIN_BTN_B};
-    Button m_btnToggle24HMode{{PIN_BTN_H, PIN_BTN_M}};
-    Button m_btnToggleDisplay{{PIN_BTN_M, PIN_BTN_C}};
-    Button m_btnToggleBlinkers{{PIN_BTN_M, PIN_BTN_B}};
-    Button m_btnFlipDisplay{{PIN_BTN_C, PIN_BTN_B}};
-
-    std::vector<Button *> m_buttons;
+    ButtonInput m_buttonInput;
+    GestureEngine m_gestures;
+    LatencyTrace m_latency;
+    LoopStats m_loopStats;
+    LedStats m_ledStats;
+    PowerStats m_powerStats;
+    PowerManager m_power;
 
     Numbers_t m_alternateNumbers;
     ElapsedTime m_timeInAltDisplayMode;
@@ -47,39 +91,17 @@ class Clock
     {
         Serial.begin(115200);
         rtc_hal_init();
+        rtc_hal_setTrim((int16_t)m_settings.Get(SETTING_RTC_TRIM));
 
         // initialize Adafruit's Neopixel library
         m_leds.begin();
+#ifdef FOXIE_INDEXED_PIXELS
+        m_leds.setIndexed(PALETTE_SIZE);
+#endif
+        m_leds.setInterruptGroup(LED_INTERRUPT_GROUP);
+        m_leds.setPartialShow(true);
         m_leds.setBrightness(m_settings.Get(SETTING_CUR_BRIGHTNESS));
 
-        m_btnHour.SetEnabled(false);
-        m_btnMinute.SetEnabled(false);
-        m_btnMinute.config.canRepeat = true;
-        m_btnMinute.config.repeatRate = 50;
-        m_btnColor.config.canRepeat = true;
-        m_btnColor.config.repeatRate = 200;
-        m_btnBrightness.config.canRepeat = true;
-
-        // special behavior buttons that require being held to activate
-        m_btnSetTime.config.delayBeforePress = DELAY_FOR_COMBINATION_BUTTONS;
-        m_btnToggle24HMode.config.delayBeforePress = DELAY_FOR_COMBINATION_BUTTONS;
-        m_btnToggleDisplay.config.delayBeforePress = DELAY_FOR_COMBINATION_BUTTONS;
-        m_btnToggleBlinkers.config.delayBeforePress = DELAY_FOR_COMBINATION_BUTTONS;
-        m_btnFlipDisplay.config.delayBeforePress = DELAY_FOR_COMBINATION_BUTTONS;
-
-        // store all our buttons in a vector so CheckForButtonEvents can
-        // use a for loop to check all the buttons
-        m_buttons.push_back(&m_btnSetTime);
-        m_buttons.push_back(&m_btnHour);
-        m_buttons.push_back(&m_btnMinute);
-        m_buttons.push_back(&m_btnAnimationMode);
-        m_buttons.push_back(&m_btnColor);
-        m_buttons.push_back(&m_btnBrightness);
-        m_buttons.push_back(&m_btnToggle24HMode);
-        m_buttons.push_back(&m_btnToggleDisplay);
-        m_buttons.push_back(&m_btnToggleBlinkers);
-        m_buttons.push_back(&m_btnFlipDisplay);
-
         ConfigureButtonHandlers();
     }
 
@@ -88,8 +110,25 @@ class Clock
         CheckForButtonEvents();
         DisplayDigits();
         m_blinkers.Update();
+        m_compositor.Composite(m_leds);
+        m_latency.Mark(LatencyTrace::STAGE_RENDER);
 
         m_leds.show();
+        m_ledStats.Transmitted(m_leds.getMaxInterruptsOff(), m_leds.getResends(), m_leds.getBitLoopError(),
+                               m_leds.getBytesSent());
+        m_latency.FrameDone();
+        rtc_hal_service();
+        m_settings.Update();
+
+        if (rtc_hal_trimChanged())
+        {
+            m_settings.Set(SETTING_RTC_TRIM, (uint32_t)rtc_hal_trim());
+            m_settings.Save();
+        }
+
+        m_loopStats.LoopDone(m_settings.IsCommitting());
+        m_powerStats.LoopDone(m_digitMgr.Animation());
+        IdleUntilNextFrame();
     }
 
     void DisplayTemporarily(const unsigned int value)
@@ -147,9 +186,24 @@ class Clock
   private:
     void CheckForButtonEvents()
     {
-        for (auto &button : m_buttons)
+        bool hadEdges = false;
+        const uint8_t pressedMask = m_buttonInput.Sample(hadEdges);
+        if (hadEdges)
         {
-            button->Update();
+            m_latency.Edge(m_buttonInput.FirstEdgeTime());
+        }
+
+        // with nothing pressed and nothing in progress, there's no work to do
+        // until the next edge arrives
+        if (!hadEdges && pressedMask == 0 && m_gestures.IsIdle())
+        {
+            return;
+        }
+
+        m_gestures.Update(pressedMask, 1 << m_state, millis());
+        if (m_gestures.IsSettled())
+        {
+            m_latency.EdgesConsumed();
         }
     }
 
@@ -170,7 +224,7 @@ class Clock
 
         case STATE_ALT_DISPLAY:
             m_digitMgr.Display(m_alternateNumbers);
-            if (m_timeInAltDisplayMode.Ms() > 1000)
+            if (m_timeInAltDisplayMode.Ms() > ALT_DISPLAY_TIME)
             {
                 m_state = STATE_NORMAL;
                 m_digitMgr.UseAnimation((AnimationType_e)m_settings.Get(SETTING_ANIMATION_TYPE));
@@ -179,213 +233,223 @@ class Clock
         }
     }
 
+    // Sleeps until the digits next need drawing or a settings commit is due,
+    // unless a button or the RTC still has work to do. A button edge wakes
+    // it early, see PowerManager.
+    void IdleUntilNextFrame()
+    {
+        if (!m_gestures.IsIdle() || rtc_hal_needsService())
+        {
+            return;
+        }
+
+        uint32_t due = m_digitMgr.NextFrameDue();
+        if (m_state == STATE_ALT_DISPLAY)
+        {
+            due = Animator::Earliest(due, millis() + ALT_DISPLAY_TIME + 1 - m_timeInAltDisplayMode.Ms());
+        }
+        if (m_settings.HasPendingWork())
+        {
+            due = Animator::Earliest(due, m_settings.NextUpdateDue());
+        }
+
+        PowerState_e state;
+        const uint32_t slept = m_power.SleepUntil(due, m_buttonInput, state);
+        m_loopStats.Slept(slept);
+        m_powerStats.Slept(m_digitMgr.Animation(), state, slept);
+    }
+
     void ConfigureButtonHandlers()
     {
-        // These C++ lambda are used as callbacks for each button and are
-        // called automatically by the Button class when events occur
-        // such as pressing a button, releasing it, repeat, etc.
+        // Everything the buttons do is listed here. Each row is active in
+        // the given clock states and fires its action when the exact
+        // combination of buttons performs the gesture, see GestureEngine.
+        // Combinations of buttons always take priority over single buttons.
+        static const GestureBinding bindings[] = {
+            // clang-format off
+            // states        buttons                gesture         ms                              action
+            {IN_ANY,         BTN_BIT_H,             GESTURE_HOLD,   DELAY_FOR_COMBINATION_BUTTONS,  ACTION_TOGGLE_SET_TIME},
+            {IN_SET_TIME,    BTN_BIT_H,             GESTURE_TAP,    0,                              ACTION_HOUR_UP},
+            {IN_SET_TIME,    BTN_BIT_M,             GESTURE_RELEASE,0,                              ACTION_MINUTE_UP},
+            {IN_SET_TIME,    BTN_BIT_M,             GESTURE_REPEAT, 50,                             ACTION_MINUTE_UP},
+            {IN_ANY_NORMAL,  BTN_BIT_M,             GESTURE_RELEASE,0,                              ACTION_NEXT_ANIMATION},
+            {IN_ANY,         BTN_BIT_C,             GESTURE_REPEAT, 200,                            ACTION_NEXT_COLOR},
+            {IN_ANY,         BTN_BIT_C,             GESTURE_RELEASE,0,                              ACTION_NEXT_COLOR},
+            {IN_ANY,         BTN_BIT_C,             GESTURE_RELEASE,0,                              ACTION_SAVE_COLOR},
+            {IN_ANY,         BTN_BIT_B,             GESTURE_PRESS,  0,                              ACTION_NEXT_BRIGHTNESS},
+            {IN_ANY,         BTN_BIT_B,             GESTURE_REPEAT, 100,                            ACTION_INCREASE_BRIGHTNESS},
+            {IN_ANY_NORMAL,  BTN_BIT_H | BTN_BIT_M, GESTURE_HOLD,   DELAY_FOR_COMBINATION_BUTTONS,  ACTION_TOGGLE_24H_MODE},
+            {IN_ANY_NORMAL,  BTN_BIT_M | BTN_BIT_C, GESTURE_HOLD,   DELAY_FOR_COMBINATION_BUTTONS,  ACTION_TOGGLE_DISPLAY_TYPE},
+            {IN_ANY_NORMAL,  BTN_BIT_M | BTN_BIT_B, GESTURE_HOLD,   DELAY_FOR_COMBINATION_BUTTONS,  ACTION_TOGGLE_BLINKERS},
+            {IN_ANY_NORMAL,  BTN_BIT_C | BTN_BIT_B, GESTURE_HOLD,   DELAY_FOR_COMBINATION_BUTTONS,  ACTION_FLIP_DISPLAY},
+            {IN_ANY_NORMAL,  BTN_BIT_H | BTN_BIT_C, GESTURE_HOLD,   DELAY_FOR_COMBINATION_BUTTONS,  ACTION_NEXT_TRANSITION},
+            // clang-format on
+        };
+
+        m_gestures.SetBindings(bindings);
+        m_gestures.handler = GestureEngine::Bind<Clock, &Clock::HandleButtonAction>(*this);
+    }
+
+    void HandleButtonAction(const uint8_t action)
+    {
+        m_latency.Dispatch();
+        DoButtonAction((ButtonAction_e)action);
+        m_latency.Mark(LatencyTrace::STAGE_MODEL);
+    }
 
+    void DoButtonAction(const ButtonAction_e action)
+    {
+        switch (action)
+        {
         ///////////////////////////////////////////////////////////////////////
-        // Set time button (H button, when held)
+        // Set time (H button, when held)
         ///////////////////////////////////////////////////////////////////////
-        m_btnSetTime.config.handlerFunc = [&](const Button::Event_e evt) {
-            if (evt == Button::PRESS)
+        case ACTION_TOGGLE_SET_TIME:
+            if (m_state != STATE_SET_TIME)
             {
-                if (m_state == STATE_NORMAL)
-                {
-                    m_state = STATE_SET_TIME;
-                    m_digitMgr.UseAnimation(ANIM_SET_TIME);
-                }
-                else
-                {
-                    m_state = STATE_NORMAL;
-                    m_digitMgr.UseAnimation((AnimationType_e)m_settings.Get(SETTING_ANIMATION_TYPE));
-                    rtc_hal_setTime(rtc_hal_hour(), rtc_hal_minute(), rtc_hal_second());
-                }
+                m_state = STATE_SET_TIME;
+                m_digitMgr.UseAnimation(ANIM_SET_TIME);
             }
-            else if (evt == Button::RELEASE)
+            else
             {
-                if (m_state == STATE_SET_TIME)
-                {
-                    m_btnHour.SetEnabled(true);
-                    m_btnMinute.SetEnabled(true);
-                    m_btnAnimationMode.SetEnabled(false);
-                    m_btnToggleDisplay.SetEnabled(false);
-                    m_btnToggleBlinkers.SetEnabled(false);
-                    m_btnToggle24HMode.SetEnabled(false);
-                    m_btnFlipDisplay.SetEnabled(false);
-                }
-                else
-                {
-                    m_btnHour.SetEnabled(false);
-                    m_btnMinute.SetEnabled(false);
-                    m_btnAnimationMode.SetEnabled(true);
-                    m_btnToggleDisplay.SetEnabled(true);
-                    m_btnToggleBlinkers.SetEnabled(true);
-                    m_btnToggle24HMode.SetEnabled(true);
-                    m_btnFlipDisplay.SetEnabled(true);
-                }
+                m_state = STATE_NORMAL;
+                m_digitMgr.UseAnimation((AnimationType_e)m_settings.Get(SETTING_ANIMATION_TYPE));
+                rtc_hal_setTime(rtc_hal_hour(), rtc_hal_minute(), rtc_hal_second());
             }
-        };
+            break;
 
         ///////////////////////////////////////////////////////////////////////
         // Hour and minute buttons (only when in STATE_SET_TIME)
         ///////////////////////////////////////////////////////////////////////
-        m_btnHour.config.handlerFunc = [&](const Button::Event_e evt) {
-            if (evt == Button::RELEASE)
-            {
-                rtc_hal_setTime(rtc_hal_hour() + 1, rtc_hal_minute(), rtc_hal_second());
-            }
-        };
+        case ACTION_HOUR_UP:
+            rtc_hal_setTime(rtc_hal_hour() + 1, rtc_hal_minute(), rtc_hal_second());
+            break;
 
-        m_btnMinute.config.handlerFunc = [&](const Button::Event_e evt) {
-            if (evt == Button::REPEAT || evt == Button::RELEASE)
-            {
-                rtc_hal_setTime(rtc_hal_hour(), rtc_hal_minute() + 1, rtc_hal_second());
-            }
-        };
+        case ACTION_MINUTE_UP:
+            rtc_hal_setTime(rtc_hal_hour(), rtc_hal_minute() + 1, rtc_hal_second());
+            break;
 
         ///////////////////////////////////////////////////////////////////////
         // Animation button
         ///////////////////////////////////////////////////////////////////////
-        m_btnAnimationMode.config.handlerFunc = [&](const Button::Event_e evt) {
-            if (evt == Button::RELEASE)
+        case ACTION_NEXT_ANIMATION:
+            m_settings.Set(SETTING_ANIMATION_TYPE, m_settings.Get(SETTING_ANIMATION_TYPE) + 1);
+            if (m_settings.Get(SETTING_ANIMATION_TYPE) >= ANIM_USER_ACCESSIBLE_TOTAL)
             {
-                m_settings.Set(SETTING_ANIMATION_TYPE, m_settings.Get(SETTING_ANIMATION_TYPE) + 1);
-                if (m_settings.Get(SETTING_ANIMATION_TYPE) >= ANIM_USER_ACCESSIBLE_TOTAL)
-                {
-                    m_settings.Set(SETTING_ANIMATION_TYPE, ANIM_NONE);
-                }
-                m_settings.Save();
-
-                DisplayTemporarily(m_settings.Get(SETTING_ANIMATION_TYPE));
+                m_settings.Set(SETTING_ANIMATION_TYPE, ANIM_NONE);
             }
-        };
+            m_settings.Save();
+
+            DisplayTemporarily(m_settings.Get(SETTING_ANIMATION_TYPE));
+            break;
 
         ///////////////////////////////////////////////////////////////////////
         // Color button
         ///////////////////////////////////////////////////////////////////////
-        m_btnColor.config.handlerFunc = [&](const Button::Event_e evt) {
-            if (evt == Button::REPEAT || evt == Button::RELEASE)
-            {
-                m_settings.Set(SETTING_COLOR, (m_settings.Get(SETTING_COLOR) + 8) & 0xFF);
-                m_digitMgr.ColorButtonPressed(m_settings.Get(SETTING_COLOR));
-            }
+        case ACTION_NEXT_COLOR:
+            m_settings.Set(SETTING_COLOR, (m_settings.Get(SETTING_COLOR) + 8) & 0xFF);
+            m_digitMgr.ColorButtonPressed(m_settings.Get(SETTING_COLOR));
+            break;
 
-            if (evt == Button::RELEASE)
-            {
-                m_settings.Save();
-            }
-        };
+        case ACTION_SAVE_COLOR:
+            m_settings.Save();
+            break;
 
         ///////////////////////////////////////////////////////////////////////
         // Toggle 24H mode on and off by pressing H+M
         ///////////////////////////////////////////////////////////////////////
-        m_btnToggle24HMode.config.handlerFunc = [&](const Button::Event_e evt) {
-            if (evt == Button::PRESS)
-            {
-                m_btnSetTime.SetEnabled(false);
-                m_btnAnimationMode.SetEnabled(false);
-
-                const auto mode = m_settings.Get(SETTING_24_HOUR_MODE);
-                m_settings.Set(SETTING_24_HOUR_MODE, mode == 0 ? 1 : 0);
-                m_settings.Save();
-                m_digitMgr.CreateDigits();
-                DisplayTemporarily(m_settings.Get(SETTING_24_HOUR_MODE) == 1 ? 24 : 12);
-            }
-            else if (evt == Button::RELEASE)
-            {
-                m_btnSetTime.SetEnabled(true);
-                m_btnAnimationMode.SetEnabled(true);
-            }
-        };
+        case ACTION_TOGGLE_24H_MODE:
+        {
+            const auto mode = m_settings.Get(SETTING_24_HOUR_MODE);
+            m_settings.Set(SETTING_24_HOUR_MODE, mode == 0 ? 1 : 0);
+            m_settings.Save();
+            m_digitMgr.CreateDigits();
+            DisplayTemporarily(m_settings.Get(SETTING_24_HOUR_MODE) == 1 ? 24 : 12);
+            break;
+        }
 
         ///////////////////////////////////////////////////////////////////////
-        // Toggle display between PXL and Edge lit using C+B
+        // Toggle display between PXL and Edge lit using M+C
         ///////////////////////////////////////////////////////////////////////
-        m_btnToggleDisplay.config.handlerFunc = [&](const Button::Event_e evt) {
-            if (evt == Button::PRESS)
-            {
-                m_blinkers.TurnOffBlinkers();
-
-                if (m_settings.Get(SETTING_DIGIT_TYPE) == DT_EDGE_LIT)
-                {
-                    m_settings.Set(SETTING_DIGIT_TYPE, DT_PIXELS);
-                }
-                else
-                {
-                    m_settings.Set(SETTING_DIGIT_TYPE, DT_EDGE_LIT);
-                }
-
-                m_settings.Save();
-                m_digitMgr.CreateDigits();
-            }
-        };
+        case ACTION_TOGGLE_DISPLAY_TYPE:
+            m_blinkers.TurnOffBlinkers();
 
-        ///////////////////////////////////////////////////////////////////////
-        // Toggle blinkers on and off by pressing B+C
-        ///////////////////////////////////////////////////////////////////////
-        m_btnToggleBlinkers.config.handlerFunc = [&](const Button::Event_e evt) {
-            if (evt == Button::PRESS)
+            if (m_settings.Get(SETTING_DIGIT_TYPE) == DT_EDGE_LIT)
             {
-                m_btnBrightness.SetEnabled(false);
-                m_btnAnimationMode.SetEnabled(false);
-
-                const auto mode = m_settings.Get(SETTING_BLINKING_SEPARATORS);
-                m_settings.Set(SETTING_BLINKING_SEPARATORS, mode == 0 ? 1 : 0);
-                m_settings.Save();
+                m_settings.Set(SETTING_DIGIT_TYPE, DT_PIXELS);
             }
-            else if (evt == Button::RELEASE)
+            else
             {
-                m_btnBrightness.SetEnabled(true);
-                m_btnAnimationMode.SetEnabled(true);
+                m_settings.Set(SETTING_DIGIT_TYPE, DT_EDGE_LIT);
             }
-        };
+
+            m_settings.Save();
+            m_digitMgr.CreateDigits();
+            break;
+
+        ///////////////////////////////////////////////////////////////////////
+        // Toggle blinkers on and off by pressing M+B
+        ///////////////////////////////////////////////////////////////////////
+        case ACTION_TOGGLE_BLINKERS:
+        {
+            const auto mode = m_settings.Get(SETTING_BLINKING_SEPARATORS);
+            m_settings.Set(SETTING_BLINKING_SEPARATORS, mode == 0 ? 1 : 0);
+            m_settings.Save();
+            break;
+        }
 
         ///////////////////////////////////////////////////////////////////////
         // Brightness button, when held, stop changing when at full brightness
         ///////////////////////////////////////////////////////////////////////
-        m_btnBrightness.config.handlerFunc = [&](const Button::Event_e evt) {
-            if (evt == Button::PRESS || evt == Button::REPEAT)
-            {
-                const uint8_t step = m_settings.Get(SETTING_MAX_BRIGHTNESS) / 8;
-                m_settings.Set(SETTING_CUR_BRIGHTNESS, m_settings.Get(SETTING_CUR_BRIGHTNESS) + step);
+        case ACTION_NEXT_BRIGHTNESS:
+        case ACTION_INCREASE_BRIGHTNESS:
+        {
+            const uint8_t step = m_settings.Get(SETTING_MAX_BRIGHTNESS) / 8;
+            m_settings.Set(SETTING_CUR_BRIGHTNESS, m_settings.Get(SETTING_CUR_BRIGHTNESS) + step);
 
-                if (m_settings.Get(SETTING_CUR_BRIGHTNESS) > m_settings.Get(SETTING_MAX_BRIGHTNESS))
+            if (m_settings.Get(SETTING_CUR_BRIGHTNESS) > m_settings.Get(SETTING_MAX_BRIGHTNESS))
+            {
+                if (action == ACTION_NEXT_BRIGHTNESS)
                 {
-                    if (evt == Button::PRESS)
-                    {
-                        m_settings.Set(SETTING_CUR_BRIGHTNESS, m_settings.Get(SETTING_MIN_BRIGHTNESS));
-                    }
-                    else
-                    {
-                        m_settings.Set(SETTING_CUR_BRIGHTNESS, m_settings.Get(SETTING_MAX_BRIGHTNESS));
-                    }
+                    m_settings.Set(SETTING_CUR_BRIGHTNESS, m_settings.Get(SETTING_MIN_BRIGHTNESS));
+                }
+                else
+                {
+                    m_settings.Set(SETTING_CUR_BRIGHTNESS, m_settings.Get(SETTING_MAX_BRIGHTNESS));
                 }
-
-                m_leds.setBrightness(m_settings.Get(SETTING_CUR_BRIGHTNESS));
             }
-        };
+
+            m_leds.setBrightness(m_settings.Get(SETTING_CUR_BRIGHTNESS));
+            m_settings.Save();
+            break;
+        }
 
         ///////////////////////////////////////////////////////////////////////
         // Flip display by pressing C+B
         ///////////////////////////////////////////////////////////////////////
-        m_btnFlipDisplay.config.handlerFunc = [&](const Button::Event_e evt) {
-            if (evt == Button::PRESS)
-            {
-                m_btnColor.SetEnabled(false);
-                m_btnBrightness.SetEnabled(false);
+        case ACTION_FLIP_DISPLAY:
+        {
+            const auto flip = m_settings.Get(SETTING_FLIP_DISPLAY);
+            m_settings.Set(SETTING_FLIP_DISPLAY, flip == 0 ? 1 : 0);
+            m_settings.Save();
+            m_digitMgr.CreateDigits();
+            m_compositor.Invalidate(); // every LED moved
+            break;
+        }
 
-                const auto flip = m_settings.Get(SETTING_FLIP_DISPLAY);
-                m_settings.Set(SETTING_FLIP_DISPLAY, flip == 0 ? 1 : 0);
-                m_settings.Save();
-                m_digitMgr.CreateDigits();
-            }
-            else if (evt == Button::RELEASE)
+        ///////////////////////////////////////////////////////////////////////
+        // Next digit transition by pressing H+C
+        ///////////////////////////////////////////////////////////////////////
+        case ACTION_NEXT_TRANSITION:
+            m_settings.Set(SETTING_TRANSITION_TYPE, m_settings.Get(SETTING_TRANSITION_TYPE) + 1);
+            if (m_settings.Get(SETTING_TRANSITION_TYPE) >= TRANSITION_TOTAL)
             {
-                m_btnColor.SetEnabled(true);
-                m_btnBrightness.SetEnabled(true);
+                m_settings.Set(SETTING_TRANSITION_TYPE, TRANSITION_NONE);
             }
-        };
+            m_settings.Save();
+
+            DisplayTemporarily(m_settings.Get(SETTING_TRANSITION_TYPE));
+            break;
+        }
     }
 };
@@ -0,0 +1,195 @@
+#pragma once
+#include <stdint.h>
+
+// Color math on packed 0x00RRGGBB pixels, all three channels at once. The
+// Cortex-M4 has SIMD instructions that work on the four bytes of a register
+// in parallel, and the same kernels are written in plain C as a reference
+// for other targets. The two give bit-for-bit the same results.
+//
+// Results always have a zero top byte, whatever the inputs' top bytes were.
+// Define FOXIE_SCALAR_COLOR to use the plain C versions on the M4 as well.
+// Defining FOXIE_DSP_COLOR_MODEL instead builds the SIMD versions anywhere,
+// with C models of the instructions, so they can be checked on the host.
+
+#if (defined(__ARM_FEATURE_DSP) && !defined(FOXIE_SCALAR_COLOR)) || defined(FOXIE_DSP_COLOR_MODEL)
+#define FOXIE_DSP_COLOR
+#endif
+
+namespace color_detail
+{
+enum
+{
+    RED_BLUE = 0x00FF00FF,
+    GREEN = 0x0000FF00,
+    RGB = 0x00FFFFFF,
+};
+
+#if defined(FOXIE_DSP_COLOR) && !defined(FOXIE_DSP_COLOR_MODEL)
+// bytes 0 and 2 of x, each widened to 16 bits: 0x00RR00BB
+static inline uint32_t Uxtb16(const uint32_t x)
+{
+    uint32_t out;
+    __asm__("uxtb16 %0, %1" : "=r"(out) : "r"(x));
+    return out;
+}
+
+// per byte a + b, stopping at 255
+static inline uint32_t Uqadd8(const uint32_t a, const uint32_t b)
+{
+    uint32_t out;
+    __asm__("uqadd8 %0, %1, %2" : "=r"(out) : "r"(a), "r"(b));
+    return out;
+}
+
+// per byte (a + b) / 2, from the 9-bit sum
+static inline uint32_t Uhadd8(const uint32_t a, const uint32_t b)
+{
+    uint32_t out;
+    __asm__("uhadd8 %0, %1, %2" : "=r"(out) : "r"(a), "r"(b));
+    return out;
+}
+
+// per byte, the larger of a and b. usub8 sets a flag for each byte where
+// a >= b, which sel then uses to pick between them. They have to stay
+// together so nothing else touches the flags in between.
+static inline uint32_t Umax8(const uint32_t a, const uint32_t b)
+{
+    uint32_t out;
+    __asm__("usub8 %0, %1, %2\n\tsel %0, %1, %2" : "=&r"(out) : "r"(a), "r"(b) : "cc");
+    return out;
+}
+#elif defined(FOXIE_DSP_COLOR)
+// The same instructions as the pseudocode in the ARMv7-M Architecture
+// Reference Manual describes them, a byte or halfword at a time
+static inline uint32_t Uxtb16(const uint32_t x)
+{
+    return (x & 0xFF) | (((x >> 16) & 0xFF) << 16);
+}
+
+static inline uint32_t Uqadd8(const uint32_t a, const uint32_t b)
+{
+    uint32_t out = 0;
+    for (int shift = 0; shift < 32; shift += 8)
+    {
+        const uint32_t sum = ((a >> shift) & 0xFF) + ((b >> shift) & 0xFF);
+        out |= (sum > 255 ? 255 : sum) << shift;
+    }
+    return out;
+}
+
+static inline uint32_t Uhadd8(const uint32_t a, const uint32_t b)
+{
+    uint32_t out = 0;
+    for (int shift = 0; shift < 32; shift += 8)
+    {
+        const uint32_t sum = ((a >> shift) & 0xFF) + ((b >> shift) & 0xFF);
+        out |= (sum >> 1) << shift;
+    }
+    return out;
+}
+
+static inline uint32_t Umax8(const uint32_t a, const uint32_t b)
+{
+    uint32_t out = 0;
+    for (int shift = 0; shift < 32; shift += 8)
+    {
+        const int32_t difference = (int32_t)((a >> shift) & 0xFF) - (int32_t)((b >> shift) & 0xFF);
+        const bool ge = difference >= 0; // the GE flag usub8 sets
+        out |= ((ge ? a : b) >> shift & 0xFF) << shift;
+    }
+    return out;
+}
+#endif
+
+// 0x00RRGGBB * weight / 256 with weight 0..256. Each channel gets its own
+// 16-bit lane, so one multiply does red and blue together.
+static inline uint32_t Weigh(const uint32_t redBlue, const uint32_t green, const uint32_t weight)
+{
+    return ((redBlue * weight >> 8) & RED_BLUE) | ((green * weight) & GREEN);
+}
+
+static inline uint32_t RedBlue(const uint32_t color)
+{
+#ifdef FOXIE_DSP_COLOR
+    return Uxtb16(color);
+#else
+    return color & RED_BLUE;
+#endif
+}
+
+// green moved down to the bottom byte. The DSP version also moves the top
+// byte to bits 16..23, which the GREEN mask later drops.
+static inline uint32_t Green(const uint32_t color)
+{
+#ifdef FOXIE_DSP_COLOR
+    return Uxtb16(color >> 8);
+#else
+    return (color >> 8) & 0xFF;
+#endif
+}
+} // namespace color_detail
+
+// brightness from 0 (off) to 255 (unchanged)
+static inline uint32_t ColorScale(const uint32_t color, const uint8_t brightness)
+{
+    using namespace color_detail;
+    return Weigh(RedBlue(color), Green(color), brightness + 1);
+}
+
+// from a at 0 to b at 255
+static inline uint32_t ColorLerp(const uint32_t a, const uint32_t b, const uint8_t t)
+{
+    using namespace color_detail;
+
+    // 0..255 onto 0..256, so both ends are exact. The sum of the two
+    // weighted lanes is at most 255 * 256, so it can't carry into the next.
+    const uint32_t weight = t + (t >> 7);
+    const uint32_t redBlue = RedBlue(a) * (256 - weight) + RedBlue(b) * weight;
+    const uint32_t green = Green(a) * (256 - weight) + Green(b) * weight;
+    return ((redBlue >> 8) & RED_BLUE) | (green & GREEN);
+}
+
+// per channel a + b, stopping at 255
+static inline uint32_t ColorAddSaturate(const uint32_t a, const uint32_t b)
+{
+#ifdef FOXIE_DSP_COLOR
+    return color_detail::Uqadd8(a, b) & color_detail::RGB;
+#else
+    uint32_t out = 0;
+    for (int shift = 0; shift < 24; shift += 8)
+    {
+        const uint32_t channel = ((a >> shift) & 0xFF) + ((b >> shift) & 0xFF);
+        out |= (channel > 255 ? 255 : channel) << shift;
+    }
+    return out;
+#endif
+}
+
+// per channel (a + b) / 2, rounded down
+static inline uint32_t ColorAverage(const uint32_t a, const uint32_t b)
+{
+#ifdef FOXIE_DSP_COLOR
+    return color_detail::Uhadd8(a, b) & color_detail::RGB;
+#else
+    // the shared bits plus half the differing ones, without a carry between
+    // channels
+    return ((a & b) + (((a ^ b) >> 1) & 0x7F7F7F)) & color_detail::RGB;
+#endif
+}
+
+// per channel, the brighter of the two
+static inline uint32_t ColorMax(const uint32_t a, const uint32_t b)
+{
+#ifdef FOXIE_DSP_COLOR
+    return color_detail::Umax8(a, b) & color_detail::RGB;
+#else
+    uint32_t out = 0;
+    for (int shift = 0; shift < 24; shift += 8)
+    {
+        const uint32_t x = (a >> shift) & 0xFF;
+        const uint32_t y = (b >> shift) & 0xFF;
+        out |= (x > y ? x : y) << shift;
+    }
+    return out;
+#endif
+}
@@ -0,0 +1,210 @@
+#pragma once
+#include "Adafruit_NeoPixel.h"
+#include "color_kernels.hpp"
+
+enum Layer_e
+{
+    // bottom to top
+    LAYER_DIGITS,
+    LAYER_TRANSITION, // numbers on their way out
+    LAYER_SEPARATORS,
+
+    TOTAL_LAYERS,
+};
+
+enum Blend_e
+{
+    BLEND_ALPHA, // covers what's below
+    BLEND_ADD,   // adds light, saturating
+};
+
+// One layer of pixels, 0xAARRGGBB. Pixels drawn without an alpha are
+// opaque if they have any color and transparent if they're black, so the
+// digit and separator drawing code doesn't need to know about alpha.
+//
+// Clearing is lazy: cleared pixels are only zeroed when the layer is
+// composited, unless they're drawn again first. Redrawing the same thing
+// every frame therefore doesn't count as a change.
+class Layer
+{
+  private:
+    enum
+    {
+        MASK_WORDS = (NUM_LEDS + 31) / 32,
+    };
+
+    uint32_t m_pixels[NUM_LEDS] = {0};
+    uint32_t m_cleared[MASK_WORDS] = {0}; // pending lazy clears
+    Blend_e m_blend{BLEND_ALPHA};
+    bool m_dirty{true};
+
+  public:
+    void SetPixel(const uint16_t n, const uint32_t color)
+    {
+        SetPixel(n, color & 0xFFFFFF, (color & 0xFFFFFF) ? 255 : 0);
+    }
+
+    void SetPixel(const uint16_t n, const uint32_t color, const uint8_t alpha)
+    {
+        if (n >= NUM_LEDS)
+        {
+            return;
+        }
+
+        m_cleared[n / 32] &= ~(1UL << (n % 32));
+        const uint32_t pixel = ((uint32_t)alpha << 24) | (color & 0xFFFFFF);
+        if (m_pixels[n] != pixel)
+        {
+            m_pixels[n] = pixel;
+            m_dirty = true;
+        }
+    }
+
+    uint32_t GetPixel(const uint16_t n) const
+    {
+        return n < NUM_LEDS ? m_pixels[n] : 0;
+    }
+
+    void ClearRange(const uint16_t first, const uint16_t count)
+    {
+        for (uint16_t n = first; n < first + count && n < NUM_LEDS; ++n)
+        {
+            m_cleared[n / 32] |= 1UL << (n % 32);
+        }
+    }
+
+    // sets the pixels first + n for each bit n in the mask
+    void FillMask(const uint16_t first, uint32_t mask, const uint32_t color)
+    {
+        for (; mask; mask &= mask - 1)
+        {
+            SetPixel(first + __builtin_ctz(mask), color);
+        }
+    }
+
+    void Clear()
+    {
+        ClearRange(0, NUM_LEDS);
+    }
+
+    void SetBlend(const Blend_e blend)
+    {
+        m_dirty |= (blend != m_blend);
+        m_blend = blend;
+    }
+
+    Blend_e Blend() const
+    {
+        return m_blend;
+    }
+
+    // Applies pending clears. Returns true if the layer changed since the
+    // last time this was called.
+    bool Settle()
+    {
+        for (uint8_t word = 0; word < MASK_WORDS; ++word)
+        {
+            for (uint32_t bits = m_cleared[word]; bits; bits &= bits - 1)
+            {
+                const uint16_t n = word * 32 + __builtin_ctz(bits);
+                if (m_pixels[n])
+                {
+                    m_pixels[n] = 0;
+                    m_dirty = true;
+                }
+            }
+            m_cleared[word] = 0;
+        }
+
+        const bool dirty = m_dirty;
+        m_dirty = false;
+        return dirty;
+    }
+
+    void Invalidate()
+    {
+        m_dirty = true;
+    }
+};
+
+// Combines the layers into the LED buffer, bottom to top, each with its own
+// blend mode, using the packed color kernels. The LEDs are only
+// written when a layer changed since the last time.
+class Compositor
+{
+  private:
+    enum
+    {
+        // pixels composited at a time before handing them to the LEDs
+        CHUNK = 32,
+    };
+
+    Layer m_layers[TOTAL_LAYERS];
+
+  public:
+    Compositor()
+    {
+        m_layers[LAYER_TRANSITION].SetBlend(BLEND_ADD);
+    }
+
+    Layer &GetLayer(const Layer_e layer)
+    {
+        return m_layers[layer];
+    }
+
+    // makes the next Composite() write every LED, e.g. when the LEDs were
+    // remapped
+    void Invalidate()
+    {
+        m_layers[LAYER_DIGITS].Invalidate();
+    }
+
+    // Returns true if the LEDs were written
+    bool Composite(Adafruit_NeoPixel &leds)
+    {
+        bool changed = false;
+        for (Layer &layer : m_layers)
+        {
+            changed |= layer.Settle();
+        }
+
+        if (!changed)
+        {
+            return false;
+        }
+
+        uint32_t out[CHUNK];
+        for (uint16_t first = 0; first < NUM_LEDS; first += CHUNK)
+        {
+            const uint16_t count = (NUM_LEDS - first < CHUNK) ? NUM_LEDS - first : CHUNK;
+            for (uint16_t i = 0; i < count; ++i)
+            {
+                out[i] = 0;
+                for (const Layer &layer : m_layers)
+                {
+                    out[i] = BlendPixel(out[i], layer.GetPixel(first + i), layer.Blend());
+                }
+            }
+            leds.setPixelColors(first, out, count);
+        }
+        return true;
+    }
+
+  private:
+    static uint32_t BlendPixel(const uint32_t under, const uint32_t over, const Blend_e blend)
+    {
+        const uint8_t alpha = over >> 24;
+        if (alpha == 0)
+        {
+            return under;
+        }
+
+        switch (blend)
+        {
+        case BLEND_ADD:
+            return ColorAddSaturate(under, ColorScale(over, alpha));
+        default:
+            return ColorLerp(under, over, alpha);
+        }
+    }
+};
@@ -2,6 +2,8 @@
 #include <vector>
 
 #include "Adafruit_NeoPixel.h"
+#include "color_kernels.hpp"
+#include "compositor.hpp"
 
 enum DigitTypes_e
 {
@@ -39,46 +41,59 @@ static inline uint32_t ColorWheel(uint8_t pos)
     return Adafruit_NeoPixel::Color(pos * 3, 255 - pos * 3, 0);
 }
 
-static inline int ScaleBrightness(const int color, const float brightness)
-{
-    const float r = ((color & 0xFF0000) >> 16) * brightness;
-    const float g = ((color & 0x00FF00) >> 8) * brightness;
-    const float b = (color & 0x0000FF) * brightness;
-    return Adafruit_NeoPixel::Color(r, g, b);
-}
-
 class Digit
 {
   public:
     enum
     {
         LEDS_PER_DIGIT = 20,
+        LEDS_PER_ROW = 2,
         OFF_COLOR = 0x000000,
         INVALID = 0xFF,
+
+        ALL_PIXELS = (1UL << LEDS_PER_DIGIT) - 1,
     };
 
   protected:
-    Adafruit_NeoPixel &m_leds;
+    Compositor &m_compositor;
+    Layer_e m_layer{LAYER_DIGITS};
     int m_first;
     int m_color;
-    float m_brightness{1.0f};
+    uint8_t m_brightness{255};
+
+    // for transitions: only pixels in the mask are drawn, and everything
+    // drawn is moved down by the offset, in rows
+    uint32_t m_mask{ALL_PIXELS};
+    int m_rowOffset{0};
 
   public:
-    Digit(Adafruit_NeoPixel &leds, const int firstLED, const int onColor)
-        : m_leds(leds), m_first(firstLED), m_color(onColor)
+    Digit(Compositor &compositor, const int firstLED, const int onColor)
+        : m_compositor(compositor), m_first(firstLED), m_color(onColor)
     {
     }
 
     virtual void Display(const int num) = 0;
 
+    // clears the digit on every layer it draws on
     void AllOff()
     {
-        for (int i = 0; i < LEDS_PER_DIGIT; ++i)
-        {
-            SetPixel(m_first + i, OFF_COLOR);
-        }
+        m_compositor.GetLayer(LAYER_DIGITS).ClearRange(m_first, LEDS_PER_DIGIT);
+        m_compositor.GetLayer(LAYER_TRANSITION).ClearRange(m_first, LEDS_PER_DIGIT);
     }
 
+    // LAYER_DIGITS, or LAYER_TRANSITION for a number on its way out
+    void UseLayer(const Layer_e layer)
+    {
+        m_layer = layer;
+    }
+
+    // true if two numbers can be shown at once, each at its own brightness
+    virtual bool CanCrossfade() const = 0;
+
+    // true if numbers are drawn as pictures on a grid of pixels, which can
+    // be moved around or counted through
+    virtual bool HasPixelGrid() const = 0;
+
     void SetColor(const int newColor)
     {
         m_color = newColor;
@@ -89,19 +104,32 @@ class Digit
         return m_color;
     }
 
-    void SetBrightness(const float brightness)
+    // 0 is off, 255 is full brightness
+    void SetBrightness(const uint8_t brightness)
     {
-        if (brightness > 1.0f)
-        {
-            return;
-        }
-
         m_brightness = brightness;
     }
 
-    void SetPixel(const int pixelNum, const int color)
+    // bit n of the mask is pixel n of this digit
+    void SetMask(const uint32_t mask)
     {
-        m_leds.setPixelColor(pixelNum, ScaleBrightness(color, m_brightness));
+        m_mask = mask;
+    }
+
+    // positive moves down, pixels moved off the digit aren't drawn
+    void SetRowOffset(const int rows)
+    {
+        m_rowOffset = rows;
+    }
+
+    // draws the pixels of this digit whose bits are set, bit n for pixel
+    // m_first + n, all in one color
+    void SetPixels(uint32_t pixels, const int color)
+    {
+        pixels &= m_mask;
+        const int shift = m_rowOffset * LEDS_PER_ROW;
+        pixels = (shift >= 0) ? pixels << shift : pixels >> -shift;
+        m_compositor.GetLayer(m_layer).FillMask(m_first, pixels & ALL_PIXELS, ColorScale(color, m_brightness));
     }
 };
 
@@ -111,13 +139,24 @@ class EdgeLitDigit : public Digit
     using Digit::Digit;
 
   public:
+    // every numeral is its own piece of acrylic
+    virtual bool CanCrossfade() const override
+    {
+        return true;
+    }
+
+    // moving the pixels would light up other numerals instead
+    virtual bool HasPixelGrid() const override
+    {
+        return false;
+    }
+
     virtual void Display(const int num)
     {
         if (num >= 0 && num <= 9)
         {
             const int row = 10 - num;
-            SetPixel(m_first + (row * 2) - 2, m_color);
-            SetPixel(m_first + (row * 2) - 1, m_color);
+            SetPixels(3UL << ((row * 2) - 2), m_color);
         }
         else
         {
@@ -132,19 +171,28 @@ class PXLDigit : public Digit
     using Digit::Digit;
 
   public:
+    // numerals share pixels, so one fading in over another just looks muddy
+    virtual bool CanCrossfade() const override
+    {
+        return false;
+    }
+
+    virtual bool HasPixelGrid() const override
+    {
+        return true;
+    }
+
     virtual void Display(const int num)
     {
         if (num >= 0 && num <= 9)
         {
             const uint8_t *data = NUMBERS + (num * LEDS_PER_DIGIT);
+            uint32_t pixels = 0;
             for (int i = 0; i < LEDS_PER_DIGIT; ++i)
             {
-                const int col = (data[i] == 0 ? OFF_COLOR : m_color);
-                if (col != OFF_COLOR)
-                {
-                    SetPixel(m_first + i, col);
-                }
+                pixels |= (uint32_t)(data[i] != 0) << i;
             }
+            SetPixels(pixels, m_color);
         }
         else
         {
@@ -25,15 +25,16 @@ class DigitManager
         DIGIT_6_LED = 100,
     };
 
-    Adafruit_NeoPixel &m_leds;
+    Compositor &m_compositor;
     Settings &m_settings;
 
     DigitPtrs_t m_digits;
     AnimatorPtr_t m_animator;
+    AnimationType_e m_animation{ANIM_NONE};
     DigitValues m_values;
 
   public:
-    DigitManager(Adafruit_NeoPixel &leds, Settings &settings) : m_leds(leds), m_settings(settings)
+    DigitManager(Compositor &compositor, Settings &settings) : m_compositor(compositor), m_settings(settings)
     {
         CreateDigits();
     }
@@ -54,9 +55,15 @@ class DigitManager
 
     void UseAnimation(const AnimationType_e type)
     {
+        m_animation = type;
         m_animator = AnimatorFactory(m_settings, m_values, type, m_settings.Get(SETTING_COLOR));
     }
 
+    AnimationType_e Animation() const
+    {
+        return m_animation;
+    }
+
     void Display(const Numbers_t numbers)
     {
         m_values.Set(numbers);
@@ -68,16 +75,22 @@ class DigitManager
         m_animator->ColorButtonPressed(wheelColor);
     }
 
+    // the millis() time the digits next need drawing, see Animator
+    uint32_t NextFrameDue()
+    {
+        return m_animator->NextFrameDue();
+    }
+
   private:
     DigitPtr_t CreateDigit(const LEDNumbers_e firstLED)
     {
         if (m_settings.Get(SETTING_DIGIT_TYPE) == DT_EDGE_LIT)
         {
-            return std::make_shared<EdgeLitDigit>(m_leds, firstLED, ColorWheel(m_settings.Get(SETTING_COLOR)));
+            return std::make_shared<EdgeLitDigit>(m_compositor, firstLED, ColorWheel(m_settings.Get(SETTING_COLOR)));
         }
         else // DT_PIXELS
         {
-            return std::make_shared<PXLDigit>(m_leds, firstLED, ColorWheel(m_settings.Get(SETTING_COLOR)));
+            return std::make_shared<PXLDigit>(m_compositor, firstLED, ColorWheel(m_settings.Get(SETTING_COLOR)));
         }
     }
 };
@@ -0,0 +1,156 @@
+#pragma once
+#include <Wire.h>
+
+// Minimal driver for the DS3231 backup clock. Unlike the generic DS3231
+// library (which uses one I2C transaction per field), this moves the whole
+// time/date register block in a single burst. The DS3231 latches its time
+// registers into a buffer at the I2C START condition, so a burst read can
+// never tear across a second boundary the way getHour() + getMinute() +
+// getSecond() can.
+class DS3231
+{
+  public:
+    enum
+    {
+        I2C_ADDRESS = 0x68,
+        I2C_CLOCK = 400000, // the DS3231 supports fast mode I2C
+
+        REG_SECONDS = 0x00, // first register of the time/date block
+        TIME_REGISTERS = 7, // seconds, minutes, hours, day, date, month, year
+
+        MAX_READ_ATTEMPTS = 3,
+    };
+
+    struct DateTime
+    {
+        uint8_t second{0};
+        uint8_t minute{0};
+        uint8_t hour{0}; // always 24H, converted if the DS3231 is in 12H mode
+        uint8_t dayOfWeek{1}; // 1-7
+        uint8_t dayOfMonth{1};
+        uint8_t month{1};
+        uint8_t year{0}; // 0-99
+    };
+
+  private:
+    TwoWire &m_wire;
+
+  public:
+    DS3231(TwoWire &wire) : m_wire(wire)
+    {
+    }
+
+    void Begin()
+    {
+        m_wire.begin();
+        m_wire.setClock(I2C_CLOCK);
+    }
+
+    // Reads the full time/date block in one transaction. Returns false if
+    // the chip didn't answer or returned values that don't decode into a
+    // valid time after a few attempts, in which case dt is untouched.
+    bool Read(DateTime &dt)
+    {
+        for (int attempt = 0; attempt < MAX_READ_ATTEMPTS; ++attempt)
+        {
+            uint8_t regs[TIME_REGISTERS];
+            if (ReadRegisters(REG_SECONDS, regs, TIME_REGISTERS) && Decode(regs, dt))
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Writes the full time/date block in one transaction. Writing the
+    // seconds register also resets the DS3231's internal sub-second
+    // countdown, so the new time starts on a clean second boundary.
+    bool Write(const DateTime &dt)
+    {
+        m_wire.beginTransmission(I2C_ADDRESS);
+        m_wire.write(REG_SECONDS);
+        m_wire.write(ToBCD(dt.second));
+        m_wire.write(ToBCD(dt.minute));
+        m_wire.write(ToBCD(dt.hour)); // bit 6 clear selects 24H mode
+        m_wire.write(ToBCD(dt.dayOfWeek));
+        m_wire.write(ToBCD(dt.dayOfMonth));
+        m_wire.write(ToBCD(dt.month));
+        m_wire.write(ToBCD(dt.year));
+        return m_wire.endTransmission() == 0;
+    }
+
+  private:
+    bool ReadRegisters(const uint8_t firstReg, uint8_t *data, const uint8_t count)
+    {
+        m_wire.beginTransmission(I2C_ADDRESS);
+        m_wire.write(firstReg);
+        if (m_wire.endTransmission(false) != 0) // repeated start, keep the bus
+        {
+            return false;
+        }
+
+        if (m_wire.requestFrom((uint8_t)I2C_ADDRESS, count) != count)
+        {
+            return false;
+        }
+
+        for (uint8_t i = 0; i < count; ++i)
+        {
+            data[i] = m_wire.read();
+        }
+        return true;
+    }
+
+    static bool Decode(const uint8_t *regs, DateTime &dt)
+    {
+        DateTime decoded;
+        decoded.second = FromBCD(regs[0] & 0x7F);
+        decoded.minute = FromBCD(regs[1] & 0x7F);
+
+        if (regs[2] & 0x40) // 12H mode, bit 5 is AM/PM
+        {
+            const uint8_t hour12 = FromBCD(regs[2] & 0x1F);
+            const bool pm = regs[2] & 0x20;
+            decoded.hour = (hour12 % 12) + (pm ? 12 : 0);
+            if (hour12 == 0 || hour12 > 12)
+            {
+                return false;
+            }
+        }
+        else
+        {
+            decoded.hour = FromBCD(regs[2] & 0x3F);
+        }
+
+        decoded.dayOfWeek = FromBCD(regs[3] & 0x07);
+        decoded.dayOfMonth = FromBCD(regs[4] & 0x3F);
+        decoded.month = FromBCD(regs[5] & 0x1F); // bit 7 is the century flag
+        decoded.year = FromBCD(regs[6]);
+
+        // a register that isn't valid BCD decodes out of range, which is
+        // also what a chip that lost power or a corrupted transfer looks like
+        if (decoded.second >= 60 || decoded.minute >= 60 || decoded.hour >= 24 || decoded.dayOfWeek < 1 ||
+            decoded.dayOfWeek > 7 || decoded.dayOfMonth < 1 || decoded.dayOfMonth > 31 || decoded.month < 1 ||
+            decoded.month > 12 || decoded.year > 99)
+        {
+            return false;
+        }
+
+        dt = decoded;
+        return true;
+    }
+
+    static uint8_t ToBCD(const uint8_t value)
+    {
+        return ((value / 10) << 4) | (value % 10);
+    }
+
+    static uint8_t FromBCD(const uint8_t bcd)
+    {
+        if ((bcd & 0x0F) > 9)
+        {
+            return 0xFF; // not BCD, will fail the range checks
+        }
+        return ((bcd >> 4) * 10) + (bcd & 0x0F);
+    }
+};
@@ -0,0 +1,148 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+#include "Adafruit_NeoPixel.h"
+
+// Easing curves for transitions, as 256 entry tables built by the compiler
+// and kept in flash. A curve maps a linear phase, fixed point with 0 at the
+// start and 255 when done, to an eased one, so easing a frame is a single
+// table lookup. Curves may use floating point: it only ever runs in the
+// compiler.
+
+namespace easing_detail
+{
+template <size_t... I>
+struct Indices
+{
+};
+
+template <size_t N, size_t... I>
+struct MakeIndices : MakeIndices<N - 1, N - 1, I...>
+{
+};
+
+template <size_t... I>
+struct MakeIndices<0, I...>
+{
+    using type = Indices<I...>;
+};
+
+template <typename Curve, typename Indices = typename MakeIndices<256>::type>
+struct Table;
+
+template <typename Curve, size_t... I>
+struct Table<Curve, Indices<I...>>
+{
+    static constexpr uint8_t values[256] = {Curve::At(I)...};
+};
+
+template <typename Curve, size_t... I>
+constexpr uint8_t Table<Curve, Indices<I...>>::values[256];
+} // namespace easing_detail
+
+// slow start, quadratic
+struct EaseIn
+{
+    static constexpr uint8_t At(const uint32_t x)
+    {
+        return x * x / 255;
+    }
+};
+
+// slow end, quadratic
+struct EaseOut
+{
+    static constexpr uint8_t At(const uint32_t x)
+    {
+        return 255 - (255 - x) * (255 - x) / 255;
+    }
+};
+
+// slow start and end: smoothstep, 3x^2 - 2x^3
+struct EaseInOut
+{
+    static constexpr uint8_t At(const uint32_t x)
+    {
+        return x * x * (3 * 255 - 2 * x) / (255 * 255);
+    }
+};
+
+// slow start and end, sharper than EaseInOut
+struct EaseInOutCubic
+{
+    static constexpr uint8_t At(const uint32_t x)
+    {
+        return x < 128 ? 4 * x * x * x / (255 * 255) : 255 - 4 * (255 - x) * (255 - x) * (255 - x) / (255 * 255);
+    }
+};
+
+// reaches the end quickly and bounces back off it a few times, like
+// something dropped
+struct EaseOutBounce
+{
+    static constexpr double N = 7.5625;
+    static constexpr double D = 2.75;
+
+    static constexpr double Bounce(const double t)
+    {
+        return t < 1 / D     ? N * t * t
+               : t < 2 / D   ? N * (t - 1.5 / D) * (t - 1.5 / D) + 0.75
+               : t < 2.5 / D ? N * (t - 2.25 / D) * (t - 2.25 / D) + 0.9375
+                             : N * (t - 2.625 / D) * (t - 2.625 / D) + 0.984375;
+    }
+
+    static constexpr uint8_t At(const uint32_t x)
+    {
+        return Bounce(x / 255.0) * 255 + 0.5;
+    }
+};
+
+namespace easing_detail
+{
+// Each transition starts from its old number and ends on its new one, so a
+// curve has to do the same
+template <typename Curve>
+constexpr bool HasEnds()
+{
+    return Curve::At(0) == 0 && Curve::At(255) == 255;
+}
+
+// whether the curve never goes back down on its way from x to the end
+template <typename Curve>
+constexpr bool RisesFrom(const uint32_t x)
+{
+    return x >= 255 || (Curve::At(x) <= Curve::At(x + 1) && RisesFrom<Curve>(x + 1));
+}
+} // namespace easing_detail
+
+static_assert(easing_detail::HasEnds<EaseIn>() && easing_detail::RisesFrom<EaseIn>(0),
+              "EaseIn must rise from 0 to 255");
+static_assert(easing_detail::HasEnds<EaseOut>() && easing_detail::RisesFrom<EaseOut>(0),
+              "EaseOut must rise from 0 to 255");
+static_assert(easing_detail::HasEnds<EaseInOut>() && easing_detail::RisesFrom<EaseInOut>(0),
+              "EaseInOut must rise from 0 to 255");
+static_assert(easing_detail::HasEnds<EaseInOutCubic>() && easing_detail::RisesFrom<EaseInOutCubic>(0),
+              "EaseInOutCubic must rise from 0 to 255");
+// bounces back on the way, so only its ends are checked
+static_assert(easing_detail::HasEnds<EaseOutBounce>(), "EaseOutBounce must go from 0 to 255");
+
+// slow start and end along half a sine wave. Adafruit_NeoPixel::sine8()
+// already keeps a table of one in flash, so this one reuses it.
+struct EaseSine
+{
+};
+
+template <typename Curve>
+static inline uint8_t Ease(const uint8_t phase)
+{
+    return easing_detail::Table<Curve>::values[phase];
+}
+
+template <>
+inline uint8_t Ease<EaseSine>(const uint8_t phase)
+{
+    // sine8() is lowest (0) at 192 and highest (255) at 64, so the rising
+    // half of the wave is 192 up to 64 after wrapping around
+    return Adafruit_NeoPixel::sine8((uint8_t)(192 + phase / 2));
+}
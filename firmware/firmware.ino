@@ -1,5 +1,13 @@
 #define FOXIE_ARTEMIS
 
+// Uncomment to print button press-to-LED latency histograms over Serial,
+// along with the loop, LED and power counters in stats.hpp
+// #define FOXIE_LATENCY_TRACE
+
+// Uncomment to keep the LEDs as a byte per pixel indexing a small palette,
+// rather than three bytes of color each
+// #define FOXIE_INDEXED_PIXELS
+
 enum HardwareConfig_e
 {
     PIN_FOR_LEDS = 2, // pin "A2" -- "LEDs" on PCB
@@ -20,6 +28,27 @@ enum Pins_e
 
 #include "clock.hpp"
 
+#if defined(AM_PART_APOLLO3)
+// The Apollo3 raises this interrupt when the supply voltage starts dropping,
+// which is our last chance to save settings that haven't been written yet.
+extern "C" void am_brownout_isr(void)
+{
+    am_hal_reset_interrupt_clear(AM_HAL_RESET_INTERRUPT_BODH);
+    Settings::FlushFromInterrupt();
+}
+
+static void EnableBrownoutInterrupt()
+{
+    am_hal_reset_interrupt_clear(AM_HAL_RESET_INTERRUPT_BODH);
+    am_hal_reset_interrupt_enable(AM_HAL_RESET_INTERRUPT_BODH);
+    NVIC_EnableIRQ(BROWNOUT_IRQn);
+}
+#else
+static void EnableBrownoutInterrupt()
+{
+}
+#endif
+
 void setup()
 {
     // The idea in this file is to keep it mostly Arduino-specific,
@@ -27,6 +56,8 @@ void setup()
     // Clock class in a very "clean" way. That's the idea, anyway...
 
     Clock clock;
+    EnableBrownoutInterrupt();
+
     while (true)
     {
         clock.Loop();
@@ -0,0 +1,14 @@
+#pragma once
+#include <stdint.h>
+
+// Raw access to a small ring of flash pages reserved for the settings
+// journal. Pages are addressed by index within that ring and words by
+// index within a page. Erased flash reads as 0xFFFFFFFF, and programming
+// can only clear bits, so a word can be programmed once per erase.
+
+int flash_hal_numPages();
+uint32_t flash_hal_wordsPerPage();
+
+uint32_t flash_hal_read(int page, uint32_t word);
+bool flash_hal_program(int page, uint32_t word, const uint32_t *data, uint32_t numWords);
+bool flash_hal_erase(int page);
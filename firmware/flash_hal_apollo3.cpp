@@ -0,0 +1,49 @@
+#include "flash_hal.hpp"
+#include <Arduino.h>
+
+// The settings journal uses the four 8KB flash pages right below the page
+// the Apollo3 core uses for EEPROM emulation (0xFE000), at the very end of
+// the 1MB of flash and far away from the sketch itself.
+enum
+{
+    JOURNAL_START = 0xF6000,
+    JOURNAL_PAGES = 4,
+};
+
+static uint32_t PageAddress(const int page)
+{
+    return JOURNAL_START + page * AM_HAL_FLASH_PAGE_SIZE;
+}
+
+static uint32_t *PagePointer(const int page)
+{
+    return (uint32_t *)(uintptr_t)PageAddress(page);
+}
+
+int flash_hal_numPages()
+{
+    return JOURNAL_PAGES;
+}
+
+uint32_t flash_hal_wordsPerPage()
+{
+    return AM_HAL_FLASH_PAGE_SIZE / sizeof(uint32_t);
+}
+
+uint32_t flash_hal_read(int page, uint32_t word)
+{
+    return PagePointer(page)[word];
+}
+
+bool flash_hal_program(int page, uint32_t word, const uint32_t *data, uint32_t numWords)
+{
+    return am_hal_flash_program_main(AM_HAL_FLASH_PROGRAM_KEY, const_cast<uint32_t *>(data), PagePointer(page) + word,
+                                     numWords) == 0;
+}
+
+bool flash_hal_erase(int page)
+{
+    const uint32_t address = PageAddress(page);
+    return am_hal_flash_page_erase(AM_HAL_FLASH_PROGRAM_KEY, AM_HAL_FLASH_ADDR2INST(address),
+                                   AM_HAL_FLASH_ADDR2PAGE(address)) == 0;
+}
@@ -0,0 +1,221 @@
+#pragma once
+#include "button_input.hpp"
+
+enum Gesture_e
+{
+    GESTURE_PRESS,      // as soon as the buttons are pressed together
+    GESTURE_RELEASE,    // when released, no matter how long they were held
+    GESTURE_TAP,        // when released, but only if no HOLD/REPEAT happened
+    GESTURE_DOUBLE_TAP, // second TAP shortly after the first
+    GESTURE_HOLD,       // once, after being held for timeMs
+    GESTURE_REPEAT,     // every timeMs while held, after REPEAT_DELAY
+};
+
+// One row of a gesture table. A binding fires its action when the exact
+// combination of buttons performs the gesture while the owner is in one of
+// the given states.
+struct GestureBinding
+{
+    uint8_t states;    // mask of owner-defined states this binding is active in
+    uint8_t buttons;   // exact combination of buttons, see ButtonBits_e
+    Gesture_e gesture;
+    uint16_t timeMs;   // hold time for GESTURE_HOLD, rate for GESTURE_REPEAT
+    uint8_t action;    // owner-defined action, passed to the handler
+};
+
+// Recognizes presses, holds, repeats and button combinations for all of the
+// buttons at once from the mask of pressed buttons, driven by a table of
+// GestureBindings. Once a gesture has started, pressing more buttons turns
+// it into a combination, while releasing some of them ends it: nothing else
+// fires until every button has been released.
+class GestureEngine
+{
+  public:
+    enum Timing_e
+    {
+        // values below are in milliseconds
+        DEBOUNCE_TIME = 20,
+        REPEAT_DELAY = 400,
+        DOUBLE_TAP_TIME = 300,
+    };
+
+    // Handlers are a plain function pointer plus the object it belongs to,
+    // stored inline, so dispatching an action never allocates. It's one
+    // indirect call through func, which calls the member function directly
+    // since Bind() has it as a template argument. Use Bind() to point it at
+    // a member function.
+    struct Handler
+    {
+        void (*func)(void *context, const uint8_t action){nullptr};
+        void *context{nullptr};
+    };
+
+    template <typename T, void (T::*Method)(const uint8_t action)>
+    static Handler Bind(T &object)
+    {
+        Handler handler;
+        handler.func = [](void *context, const uint8_t action) { (static_cast<T *>(context)->*Method)(action); };
+        handler.context = &object;
+        return handler;
+    }
+
+    Handler handler;
+
+  private:
+    const GestureBinding *m_bindings{nullptr};
+    size_t m_numBindings{0};
+
+    uint8_t m_rawMask{0};
+    uint32_t m_rawChangedAt{0};
+    uint8_t m_mask{0}; // debounced
+
+    uint8_t m_chord{0}; // combination that the current gesture is using
+    uint32_t m_chordStart{0};
+    bool m_ended{false};    // buttons were partially released
+    bool m_consumed{false}; // a HOLD or REPEAT fired for this chord
+    uint16_t m_heldFor{0};  // HOLDs up to this time have already fired
+    uint32_t m_lastRepeat{0}; // starts at the press, so the first REPEAT is at REPEAT_DELAY
+
+    uint8_t m_lastTapChord{0};
+    uint32_t m_lastTapTime{0};
+
+  public:
+    template <size_t N>
+    void SetBindings(const GestureBinding (&bindings)[N])
+    {
+        m_bindings = bindings;
+        m_numBindings = N;
+    }
+
+    void Update(const uint8_t pressedMask, const uint8_t stateMask, const uint32_t now)
+    {
+        if (pressedMask != m_rawMask)
+        {
+            m_rawMask = pressedMask;
+            m_rawChangedAt = now;
+        }
+
+        if (m_rawMask != m_mask && now - m_rawChangedAt >= DEBOUNCE_TIME)
+        {
+            const uint8_t previous = m_mask;
+            m_mask = m_rawMask;
+            OnMaskChanged(previous, stateMask, now);
+        }
+        else if (m_mask != 0 && !m_ended)
+        {
+            CheckHoldAndRepeat(stateMask, now);
+        }
+    }
+
+    // true once the debounced buttons have caught up with the pins, so
+    // every edge so far has either been acted on or turned out to be bounce
+    bool IsSettled() const
+    {
+        return m_rawMask == m_mask;
+    }
+
+    // true when nothing will happen until a button is pressed
+    bool IsIdle() const
+    {
+        return m_rawMask == 0 && m_mask == 0;
+    }
+
+  private:
+    void OnMaskChanged(const uint8_t previous, const uint8_t stateMask, const uint32_t now)
+    {
+        if (m_mask == 0)
+        {
+            if (!m_ended)
+            {
+                Fire(GESTURE_RELEASE, stateMask);
+                if (!m_consumed)
+                {
+                    Fire(GESTURE_TAP, stateMask);
+                    CheckDoubleTap(stateMask, now);
+                }
+            }
+
+            m_chord = 0;
+            m_ended = false;
+            m_consumed = false;
+        }
+        else if ((m_mask & previous) == previous && !m_ended && !m_consumed)
+        {
+            // more buttons were pressed, start over as a combination
+            m_chord = m_mask;
+            m_chordStart = now;
+            m_heldFor = 0;
+            m_lastRepeat = now;
+            Fire(GESTURE_PRESS, stateMask);
+        }
+        else
+        {
+            m_ended = true;
+        }
+    }
+
+    void CheckHoldAndRepeat(const uint8_t stateMask, const uint32_t now)
+    {
+        const uint32_t elapsed = now - m_chordStart;
+        for (size_t i = 0; i < m_numBindings; ++i)
+        {
+            const GestureBinding &binding = m_bindings[i];
+            if (!Matches(binding, stateMask))
+            {
+                continue;
+            }
+
+            if (binding.gesture == GESTURE_HOLD && binding.timeMs > m_heldFor && binding.timeMs <= elapsed)
+            {
+                m_consumed = true;
+                Dispatch(binding);
+            }
+            else if (binding.gesture == GESTURE_REPEAT && elapsed >= REPEAT_DELAY &&
+                     now - m_lastRepeat >= binding.timeMs)
+            {
+                m_consumed = true;
+                m_lastRepeat = now;
+                Dispatch(binding);
+            }
+        }
+        m_heldFor = elapsed > 0xFFFF ? 0xFFFF : elapsed;
+    }
+
+    void CheckDoubleTap(const uint8_t stateMask, const uint32_t now)
+    {
+        if (m_lastTapChord == m_chord && now - m_lastTapTime <= DOUBLE_TAP_TIME)
+        {
+            Fire(GESTURE_DOUBLE_TAP, stateMask);
+            m_lastTapChord = 0;
+        }
+        else
+        {
+            m_lastTapChord = m_chord;
+            m_lastTapTime = now;
+        }
+    }
+
+    void Fire(const Gesture_e gesture, const uint8_t stateMask)
+    {
+        for (size_t i = 0; i < m_numBindings; ++i)
+        {
+            if (m_bindings[i].gesture == gesture && Matches(m_bindings[i], stateMask))
+            {
+                Dispatch(m_bindings[i]);
+            }
+        }
+    }
+
+    bool Matches(const GestureBinding &binding, const uint8_t stateMask) const
+    {
+        return binding.buttons == m_chord && (binding.states & stateMask);
+    }
+
+    void Dispatch(const GestureBinding &binding)
+    {
+        if (handler.func)
+        {
+            handler.func(handler.context, binding.action);
+        }
+    }
+};
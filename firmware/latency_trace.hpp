@@ -0,0 +1,181 @@
+#pragma once
+#include "stats.hpp"
+
+// Measures press-to-photon latency: the time from a button's pin edge until
+// the resulting change has been sent to the LEDs, broken down by stage.
+// Define FOXIE_LATENCY_TRACE (see firmware.ino) to collect histograms and
+// print them over Serial every few seconds, along with the counters in
+// stats.hpp. When it isn't defined, every function here is empty and
+// compiles away.
+class LatencyTrace
+{
+  public:
+    enum Stage_e
+    {
+        STAGE_DISPATCH,  // gesture recognized, action handler called
+        STAGE_MODEL,     // action handler finished (settings, RTC updated)
+        STAGE_RENDER,    // new frame drawn into the LED buffer
+        STAGE_TRANSMIT,  // frame finished sending to the LEDs
+
+        TOTAL_STAGES,
+    };
+
+#ifdef FOXIE_LATENCY_TRACE
+    enum
+    {
+        // bucket n holds latencies below (FIRST_BUCKET_US << n), the last
+        // bucket holds everything else
+        FIRST_BUCKET_US = 250,
+        TOTAL_BUCKETS = 12, // up to 256ms
+    };
+
+    struct Histogram
+    {
+        uint16_t buckets[TOTAL_BUCKETS];
+        uint32_t max;
+    };
+
+  private:
+    Histogram m_histograms[TOTAL_STAGES] = {};
+    uint32_t m_stamps[TOTAL_STAGES] = {0};
+    uint32_t m_start{0};
+    bool m_edgePending{false};
+    bool m_active{false};
+    bool m_hasSamples{false};
+    ReportTimer m_report;
+
+  public:
+    // A pin edge arrived at the given micros() time. Until an action or
+    // EdgesConsumed() takes it, later edges don't move the start, so
+    // latency is measured from the first one.
+    void Edge(const uint32_t timestamp)
+    {
+        if (!m_active && !m_edgePending)
+        {
+            m_start = timestamp;
+            m_edgePending = true;
+        }
+    }
+
+    // The gesture engine has dealt with the edges so far. If that didn't
+    // start an action, they caused none, and whatever comes next, like a
+    // repeat while the button is held, is measured from when it happens.
+    void EdgesConsumed()
+    {
+        m_edgePending = false;
+    }
+
+    // An action is starting. Held buttons repeat without any new edge, in
+    // which case the latency is measured from the repeat itself.
+    void Dispatch()
+    {
+        if (!m_active)
+        {
+            m_active = true;
+            if (!m_edgePending)
+            {
+                m_start = micros();
+            }
+            m_edgePending = false;
+            Mark(STAGE_DISPATCH);
+        }
+    }
+
+    void Mark(const Stage_e stage)
+    {
+        if (m_active)
+        {
+            m_stamps[stage] = micros();
+        }
+    }
+
+    // latencies from edge to stage since the start
+    const Histogram &GetHistogram(const Stage_e stage) const
+    {
+        return m_histograms[stage];
+    }
+
+    // Call after the frame has been sent. Finishes the current measurement,
+    // if there is one, and prints the histograms now and then.
+    void FrameDone()
+    {
+        if (m_active)
+        {
+            Mark(STAGE_TRANSMIT);
+            for (int i = 0; i < TOTAL_STAGES; ++i)
+            {
+                Add(m_histograms[i], m_stamps[i] - m_start);
+            }
+            m_active = false;
+            m_hasSamples = true;
+        }
+
+        if (m_hasSamples && m_report.Due())
+        {
+            Report();
+        }
+    }
+
+  private:
+    static void Add(Histogram &histogram, const uint32_t latency)
+    {
+        int bucket = 0;
+        while (bucket < TOTAL_BUCKETS - 1 && latency >= ((uint32_t)FIRST_BUCKET_US << bucket))
+        {
+            ++bucket;
+        }
+
+        if (histogram.buckets[bucket] < 0xFFFF)
+        {
+            ++histogram.buckets[bucket];
+        }
+        histogram.max = latency > histogram.max ? latency : histogram.max;
+    }
+
+    void Report()
+    {
+        static const char *const names[TOTAL_STAGES] = {"dispatch", "model", "render", "transmit"};
+
+        Serial.println("latency from edge, count per bucket (us), max us:");
+        for (int i = 0; i < TOTAL_STAGES; ++i)
+        {
+            Serial.print(names[i]);
+            Serial.print(":");
+            for (int bucket = 0; bucket < TOTAL_BUCKETS; ++bucket)
+            {
+                if (m_histograms[i].buckets[bucket])
+                {
+                    const bool last = (bucket == TOTAL_BUCKETS - 1);
+                    Serial.print(last ? " >=" : " <");
+                    Serial.print((uint32_t)FIRST_BUCKET_US << (last ? bucket - 1 : bucket));
+                    Serial.print("=");
+                    Serial.print(m_histograms[i].buckets[bucket]);
+                }
+            }
+            Serial.print(" max=");
+            Serial.println(m_histograms[i].max);
+        }
+    }
+#else
+  public:
+    void Edge(const uint32_t timestamp)
+    {
+    }
+
+    void EdgesConsumed()
+    {
+    }
+
+    void Dispatch()
+    {
+    }
+
+    void Mark(const Stage_e stage)
+    {
+    }
+
+    void FrameDone()
+    {
+    }
+#endif
+};
@@ -0,0 +1,22 @@
+#pragma once
+#include <stdint.h>
+
+enum PowerState_e
+{
+    POWER_AWAKE,
+    POWER_SLEEP,      // core stopped, clocks and peripherals running
+    POWER_DEEP_SLEEP, // core and most clocks stopped
+
+    TOTAL_POWER_STATES,
+};
+
+// Low-power waiting between frames. Call with interrupts disabled, after
+// checking there's nothing left to do: an interrupt that's already pending,
+// or arrives while asleep, wakes the processor right away, and it runs once
+// interrupts are enabled again. Otherwise it wakes after ms milliseconds or
+// at the start of the RTC's next second, whichever is first.
+//
+// Returns the state it actually slept in, which is POWER_SLEEP when deep
+// sleep was asked for but isn't usable on this hardware.
+
+PowerState_e power_hal_sleep(PowerState_e state, uint32_t ms);
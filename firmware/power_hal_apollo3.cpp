@@ -0,0 +1,92 @@
+#include "power_hal.hpp"
+#include <Arduino.h>
+
+// The Apollo3 core runs the system timer (STIMER) from the 3MHz HFRC for
+// millis() and micros(). It keeps counting in normal sleep, and the HFRC
+// stays on in deep sleep for as long as the STIMER needs it. Its compare G
+// isn't used by the core, so it's the wake-up timer here.
+//
+// The RTC runs from the 32kHz crystal whatever the state. Its alarm repeats
+// every second at hundredths 0, waking us right as each second starts.
+enum
+{
+    STIMER_TICKS_PER_MS = 3000,
+    WAKE_COMPARE = 6, // compare G
+
+    // deep sleeps at least this long check the STIMER against the RTC
+    CHECK_MIN_HUNDREDTHS = 5,
+};
+
+// cleared if the STIMER turns out to stop in deep sleep after all, which
+// would leave millis() behind
+static bool s_deepSleepWorks = true;
+
+extern "C" void am_stimer_cmpr6_isr(void)
+{
+    am_hal_stimer_int_clear(AM_HAL_STIMER_INT_COMPAREG);
+}
+
+extern "C" void am_rtc_isr(void)
+{
+    am_hal_rtc_int_clear(AM_HAL_RTC_INT_ALM);
+}
+
+static void Configure()
+{
+    CTIMER->STCFG |= AM_HAL_STIMER_CFG_COMPARE_G_ENABLE;
+    NVIC_EnableIRQ(STIMER_CMPR6_IRQn);
+
+    am_hal_rtc_time_t alarm = {}; // hundredths 0
+    am_hal_rtc_alarm_set(&alarm, AM_HAL_RTC_ALM_RPT_SEC);
+    NVIC_EnableIRQ(RTC_IRQn);
+}
+
+// the RTC's time within the current minute
+static uint32_t RtcHundredths()
+{
+    am_hal_rtc_time_t time;
+    am_hal_rtc_time_get(&time);
+    return time.ui32Second * 100 + time.ui32Hundredths;
+}
+
+static void Sleep(const bool deep, const uint32_t ms)
+{
+    am_hal_stimer_compare_delta_set(WAKE_COMPARE, ms * STIMER_TICKS_PER_MS);
+    am_hal_stimer_int_clear(AM_HAL_STIMER_INT_COMPAREG);
+    am_hal_stimer_int_enable(AM_HAL_STIMER_INT_COMPAREG);
+    am_hal_rtc_int_clear(AM_HAL_RTC_INT_ALM);
+    am_hal_rtc_int_enable(AM_HAL_RTC_INT_ALM);
+
+    am_hal_sysctrl_sleep(deep ? AM_HAL_SYSCTRL_SLEEP_DEEP : AM_HAL_SYSCTRL_SLEEP_NORMAL);
+
+    am_hal_rtc_int_disable(AM_HAL_RTC_INT_ALM);
+    am_hal_stimer_int_disable(AM_HAL_STIMER_INT_COMPAREG);
+}
+
+PowerState_e power_hal_sleep(PowerState_e state, uint32_t ms)
+{
+    static bool configured = false;
+    if (!configured)
+    {
+        Configure();
+        configured = true;
+    }
+
+    if (state != POWER_DEEP_SLEEP || !s_deepSleepWorks)
+    {
+        Sleep(false, ms);
+        return POWER_SLEEP;
+    }
+
+    const uint32_t rtcBefore = RtcHundredths();
+    const uint32_t counterBefore = am_hal_stimer_counter_get();
+    Sleep(true, ms);
+    const uint32_t rtcElapsed = (RtcHundredths() + 6000 - rtcBefore) % 6000;
+    const uint32_t counterElapsed = (am_hal_stimer_counter_get() - counterBefore) / (STIMER_TICKS_PER_MS * 10);
+
+    if (rtcElapsed >= CHECK_MIN_HUNDREDTHS && counterElapsed < rtcElapsed / 2)
+    {
+        s_deepSleepWorks = false;
+    }
+    return POWER_DEEP_SLEEP;
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include "button_input.hpp"
+#include "power_hal.hpp"
+
+// Puts the processor to sleep between frames, as deeply as the wait allows.
+// Short waits for an animation's next frame use normal sleep, which keeps
+// Serial and the timers running. Waits that run to the next second use deep
+// sleep, which the RTC's second alarm ends right on time. A button edge
+// ends either one early. Nothing is powered off, so there's nothing to
+// restore on waking and the loop carries on straight away.
+class PowerManager
+{
+  private:
+    enum
+    {
+        // ms, shorter waits stay in normal sleep
+        DEEP_SLEEP_MIN = 100,
+    };
+
+  public:
+    // Sleeps until the millis() time due at the latest. Returns how long it
+    // slept in us, and the state it slept in.
+    uint32_t SleepUntil(const uint32_t due, const ButtonInput &buttons, PowerState_e &state)
+    {
+        const int32_t wait = (int32_t)(due - millis());
+        state = wait >= DEEP_SLEEP_MIN ? POWER_DEEP_SLEEP : POWER_SLEEP;
+        if (state == POWER_DEEP_SLEEP)
+        {
+            // the UART stops in deep sleep, so send whatever's queued first
+            Serial.flush();
+        }
+
+        // with interrupts off, an edge can't slip in between checking for
+        // one and going to sleep
+        uint32_t slept = 0;
+        noInterrupts();
+        const int32_t remaining = (int32_t)(due - millis());
+        if (remaining > 0 && !buttons.HasEdges())
+        {
+            const uint32_t start = micros();
+            state = power_hal_sleep(state, remaining);
+            slept = micros() - start;
+        }
+        else
+        {
+            state = POWER_AWAKE;
+        }
+        interrupts();
+
+        return slept;
+    }
+};
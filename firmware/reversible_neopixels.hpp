@@ -14,19 +14,27 @@ class ReversibleNeopixels : public Adafruit_NeoPixel
         NUM_BLINKER_LEDS = 2,
     };
 
+    // from SETTING_FLIP_DISPLAY, pixels up to m_lastFlippedPixel are
+    // mirrored when it's set
+    bool m_flipped{false};
+    uint16_t m_lastFlippedPixel{0};
+    bool m_subscribed{false}; // if not, the setting is read every time
+
   public:
     // See Adafruit_Neopixel constructor for more details
     ReversibleNeopixels(Settings &settings, uint16_t numPixels, uint16_t pin, neoPixelType type)
-        : m_settings(settings), Adafruit_NeoPixel(numPixels, pin, type)
+        : Adafruit_NeoPixel(numPixels, pin, type), m_settings(settings)
     {
+        m_lastFlippedPixel = numPixels - 1 - NUM_BLINKER_LEDS;
+        m_subscribed = m_settings.Subscribe(
+            SettingsListener::Bind<ReversibleNeopixels, &ReversibleNeopixels::OnSettingsChanged>(*this));
     }
 
     virtual void setPixelColor(uint16_t n, uint32_t c) override
     {
-        const int lastPixelNum = (numPixels() - 1 - NUM_BLINKER_LEDS);
-        if (m_settings.Get(SETTING_FLIP_DISPLAY) && n <= lastPixelNum)
+        if (Flipped() && n <= m_lastFlippedPixel)
         {
-            Adafruit_NeoPixel::setPixelColor(lastPixelNum - n, c);
+            Adafruit_NeoPixel::setPixelColor(m_lastFlippedPixel - n, c);
         }
         else
         {
@@ -34,20 +42,36 @@ class ReversibleNeopixels : public Adafruit_NeoPixel
         }
     }
 
-    void FadeToOff()
+  protected:
+    // runs that reach into the mirrored pixels are split in two, and the
+    // mirrored part is written backwards
+    virtual void writeSpan(uint16_t first, int8_t step, const uint32_t *colors, uint32_t mask, uint32_t c,
+                           uint16_t count) override
     {
-        for (int brightness = m_settings.Get(SETTING_CUR_BRIGHTNESS); brightness >= 0; brightness -= 3)
+        if (!Flipped() || first > m_lastFlippedPixel)
+        {
+            Adafruit_NeoPixel::writeSpan(first, step, colors, mask, c, count);
+            return;
+        }
+
+        const uint16_t toEnd = m_lastFlippedPixel + 1 - first;
+        const uint16_t mirrored = (count < toEnd) ? count : toEnd;
+        Adafruit_NeoPixel::writeSpan(m_lastFlippedPixel - first, -step, colors, mask, c, mirrored);
+        if (count > mirrored)
         {
-            setBrightness(brightness);
-            show();
+            Adafruit_NeoPixel::writeSpan(first + mirrored, step, colors ? colors + mirrored : nullptr,
+                                         mirrored < 32 ? mask >> mirrored : 0, c, count - mirrored);
         }
-        setBrightness(0);
-        show();
     }
 
-    void SetToCurrentBrightness()
+  private:
+    bool Flipped() const
+    {
+        return m_subscribed ? m_flipped : m_settings.Get(SETTING_FLIP_DISPLAY);
+    }
+
+    void OnSettingsChanged(const Settings &settings)
     {
-        setBrightness(m_settings.Get(SETTING_CUR_BRIGHTNESS));
-        show();
+        m_flipped = settings.Get(SETTING_FLIP_DISPLAY);
     }
 };
\ No newline at end of file
@@ -0,0 +1,106 @@
+#pragma once
+#include <stdint.h>
+
+// Estimates how fast or slow the internal RTC runs compared to a more
+// accurate reference clock (the DS3231). Each sample is the offset between
+// the two clocks, taken right at a reference seconds edge. The drift is the
+// change in that offset over a long baseline, so the ~10ms uncertainty of
+// each individual sample becomes insignificant.
+class RtcDriftEstimator
+{
+  public:
+    enum
+    {
+        SECONDS_PER_DAY = 86400L,
+        HUNDREDTHS_PER_DAY = SECONDS_PER_DAY * 100L,
+
+        // don't trust a drift measured over less than this many seconds
+        MIN_BASELINE_SECONDS = 6L * 60 * 60,
+
+        // The internal RTC's XT oscillator can be trimmed in steps of 2^-20,
+        // which is roughly 0.95 parts per million.
+        TRIM_STEP_PPB = 954,
+        TRIM_MIN = -1024, // CALXT is an 11-bit signed value
+        TRIM_MAX = 1023,
+    };
+
+  private:
+    bool m_hasBaseline{false};
+    int32_t m_baselineOffset{0}; // hundredths, local - reference
+    int32_t m_lastRefSecond{0};  // reference second of day at last sample
+    int32_t m_elapsed{0};        // reference seconds since the baseline
+
+  public:
+    void Reset()
+    {
+        m_hasBaseline = false;
+    }
+
+    // refSecondOfDay is the reference clock right as its seconds ticked
+    // over, localHundredthsOfDay is the internal RTC at that same moment.
+    // Returns true once enough time has passed to produce a drift, in parts
+    // per billion. Positive means the internal RTC is running fast.
+    bool AddSample(const int32_t refSecondOfDay, const int32_t localHundredthsOfDay, int32_t &driftPpb)
+    {
+        const int32_t offset = WrapHundredths(localHundredthsOfDay - refSecondOfDay * 100L);
+        if (!m_hasBaseline)
+        {
+            m_hasBaseline = true;
+            m_baselineOffset = offset;
+            m_lastRefSecond = refSecondOfDay;
+            m_elapsed = 0;
+            return false;
+        }
+
+        // samples are hours apart, so the reference can only have moved
+        // forward by less than a day since the last one
+        int32_t delta = refSecondOfDay - m_lastRefSecond;
+        if (delta < 0)
+        {
+            delta += SECONDS_PER_DAY;
+        }
+        m_lastRefSecond = refSecondOfDay;
+        m_elapsed += delta;
+
+        if (m_elapsed < MIN_BASELINE_SECONDS)
+        {
+            return false;
+        }
+
+        // hundredths per second -> ppb is a factor of 1e7
+        const int64_t drift = WrapHundredths(offset - m_baselineOffset);
+        driftPpb = (int32_t)((drift * 10000000LL) / m_elapsed);
+        return true;
+    }
+
+    // The trim for the internal RTC to keep time with the reference, from
+    // the trim it had while drifting by driftPpb. Positive CALXT values add
+    // XT cycles, which makes the RTC run faster, so a fast RTC gets a lower
+    // trim.
+    static int CorrectedTrim(const int trim, const int32_t driftPpb)
+    {
+        const int32_t halfStep = (driftPpb >= 0 ? TRIM_STEP_PPB : -TRIM_STEP_PPB) / 2;
+        return ClampTrim(trim - (driftPpb + halfStep) / TRIM_STEP_PPB);
+    }
+
+    // the nearest trim that CALXT can hold
+    static int ClampTrim(const int trim)
+    {
+        return trim < TRIM_MIN ? TRIM_MIN : trim > TRIM_MAX ? TRIM_MAX : trim;
+    }
+
+  private:
+    // keeps an offset within +/- half a day, so midnight isn't a problem
+    static int32_t WrapHundredths(int32_t hundredths)
+    {
+        if (hundredths > HUNDREDTHS_PER_DAY / 2)
+        {
+            hundredths -= HUNDREDTHS_PER_DAY;
+        }
+        else if (hundredths < -HUNDREDTHS_PER_DAY / 2)
+        {
+            hundredths += HUNDREDTHS_PER_DAY;
+        }
+        return hundredths;
+    }
+};
@@ -2,6 +2,8 @@
 
 void rtc_hal_init();
 void rtc_hal_update();
+void rtc_hal_service(); // background work, call once per loop
+bool rtc_hal_needsService(); // true if rtc_hal_service() is waiting on something
 
 int rtc_hal_hour();
 int rtc_hal_hourFormat12();
@@ -12,3 +14,11 @@ int rtc_hal_millis();
 
 void rtc_hal_setTime(int h, int m, int s);
 void rtc_hal_setDate(int d, int m, int y);
+
+// Trim for the internal RTC oscillator, in hardware calibration steps
+// (about 0.95ppm each). When a backup clock is fitted, the trim is learned
+// automatically and rtc_hal_trimChanged() returns true once so the owner can
+// persist the new value.
+void rtc_hal_setTrim(int trim);
+int rtc_hal_trim();
+bool rtc_hal_trimChanged();
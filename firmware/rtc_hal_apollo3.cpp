@@ -1,13 +1,50 @@
 #include "rtc_hal.hpp"
 #include <RTC.h>
 
+#include "rtc_drift.hpp"
+
 // Uncomment if using the backup clock modification
 // #define UseDS3232
 
+// CALXT, see RtcDriftEstimator::CorrectedTrim()
+static int s_trim = 0;
+static bool s_trimChanged = false;
+
 #ifdef UseDS3232
-#include <DS3231.h>
-#include <Wire.h>
-DS3231 BackupClock;
+#include "ds3231.hpp"
+DS3231 g_backupClock(Wire);
+
+// Writes to the backup clock are deferred to rtc_hal_service() so that
+// holding a button in Set Time mode doesn't put an I2C transaction inside
+// every button handler. Only the latest time matters, so pending writes
+// simply collapse into one.
+static bool s_backupWritePending = false;
+static unsigned long s_lastBackupWrite = 0;
+enum
+{
+    BACKUP_WRITE_INTERVAL = 250, // ms, minimum time between DS3231 writes
+
+    DRIFT_SAMPLE_INTERVAL = 60UL * 60 * 1000, // ms, time between drift samples
+    DRIFT_EDGE_TIMEOUT = 1500, // ms, give up looking for a seconds edge after this
+};
+
+// Drift samples have to be taken right as the DS3231's seconds tick over,
+// since it has no sub-second registers. Instead of blocking until that
+// happens, rtc_hal_service() polls it once per loop until it sees the edge,
+// which only happens for about one second every DRIFT_SAMPLE_INTERVAL.
+enum DriftState_e
+{
+    DRIFT_IDLE,
+    DRIFT_WAIT_FOR_EDGE,
+};
+static RtcDriftEstimator s_drift;
+static DriftState_e s_driftState = DRIFT_IDLE;
+static bool s_driftSampledOnce = false;
+static unsigned long s_lastDriftSample = 0;
+static unsigned long s_edgeSearchStarted = 0;
+static uint8_t s_edgeSearchSecond = 0;
+
+static void ServiceDriftEstimator();
 #endif
 
 APM3_RTC g_rtc;
@@ -17,14 +54,149 @@ void rtc_hal_init()
     // rtc_hal_setTime() ...
 
 #ifdef UseDS3232
-    Wire.begin();
-    bool h12, PM;
-    rtc_hal_setTime(BackupClock.getHour(h12, PM), BackupClock.getMinute(), BackupClock.getSecond());
+    g_backupClock.Begin();
+
+    DS3231::DateTime dt;
+    if (g_backupClock.Read(dt))
+    {
+        // set the internal RTC directly, rtc_hal_setTime() would write the
+        // same time straight back to the DS3231
+        g_rtc.setTime(dt.hour, dt.minute, dt.second, 0, dt.dayOfMonth, dt.month, dt.year);
+    }
 #endif
 
     rtc_hal_update();
 }
 
+void rtc_hal_service()
+{
+#ifdef UseDS3232
+    if (s_backupWritePending && millis() - s_lastBackupWrite >= BACKUP_WRITE_INTERVAL)
+    {
+        // g_rtc keeps running while the write is pending, so write what it
+        // says now rather than the time that was originally requested
+        g_rtc.getTime();
+
+        DS3231::DateTime dt;
+        dt.hour = g_rtc.hour;
+        dt.minute = g_rtc.minute;
+        dt.second = g_rtc.seconds;
+        dt.dayOfWeek = g_rtc.weekday + 1;
+        dt.dayOfMonth = g_rtc.dayOfMonth;
+        dt.month = g_rtc.month;
+        dt.year = g_rtc.year;
+
+        // if the write fails, leave it pending and try again next interval
+        s_backupWritePending = !g_backupClock.Write(dt);
+        s_lastBackupWrite = millis();
+    }
+    else if (!s_backupWritePending)
+    {
+        ServiceDriftEstimator();
+    }
+#endif
+}
+
+bool rtc_hal_needsService()
+{
+#ifdef UseDS3232
+    return s_backupWritePending || s_driftState == DRIFT_WAIT_FOR_EDGE;
+#else
+    return false;
+#endif
+}
+
+#ifdef UseDS3232
+static void ServiceDriftEstimator()
+{
+    DS3231::DateTime dt;
+    switch (s_driftState)
+    {
+    case DRIFT_IDLE:
+        if (s_driftSampledOnce && millis() - s_lastDriftSample < DRIFT_SAMPLE_INTERVAL)
+        {
+            return;
+        }
+
+        if (g_backupClock.Read(dt))
+        {
+            s_edgeSearchSecond = dt.second;
+            s_edgeSearchStarted = millis();
+            s_driftState = DRIFT_WAIT_FOR_EDGE;
+        }
+        else
+        {
+            s_lastDriftSample = millis(); // no backup clock, try again later
+            s_driftSampledOnce = true;
+        }
+        break;
+
+    case DRIFT_WAIT_FOR_EDGE:
+        if (!g_backupClock.Read(dt) || millis() - s_edgeSearchStarted > DRIFT_EDGE_TIMEOUT)
+        {
+            s_driftState = DRIFT_IDLE;
+            s_lastDriftSample = millis();
+            s_driftSampledOnce = true;
+            return;
+        }
+
+        if (dt.second != s_edgeSearchSecond)
+        {
+            g_rtc.getTime();
+            const int32_t refSecond = (dt.hour * 60L + dt.minute) * 60L + dt.second;
+            const int32_t localHundredths =
+                ((g_rtc.hour * 60L + g_rtc.minute) * 60L + g_rtc.seconds) * 100L + g_rtc.hundredths;
+
+            int32_t driftPpb = 0;
+            if (s_drift.AddSample(refSecond, localHundredths, driftPpb))
+            {
+                // the measured drift already includes the current trim, so
+                // the correction is relative to it
+                const int trim = RtcDriftEstimator::CorrectedTrim(s_trim, driftPpb);
+                s_trimChanged = (trim != s_trim);
+                rtc_hal_setTrim(trim);
+
+                // we're exactly on a seconds edge, so resync to the backup
+                // clock and start a new baseline with the new trim
+                g_rtc.setTime(dt.hour, dt.minute, dt.second, 0, dt.dayOfMonth, dt.month, dt.year);
+                s_drift.Reset();
+                s_drift.AddSample(refSecond, refSecond * 100L, driftPpb);
+            }
+
+            s_driftState = DRIFT_IDLE;
+            s_lastDriftSample = millis();
+            s_driftSampledOnce = true;
+        }
+        break;
+    }
+}
+#endif
+
+void rtc_hal_setTrim(int trim)
+{
+    trim = RtcDriftEstimator::ClampTrim(trim);
+    s_trim = trim;
+
+#if defined(AM_PART_APOLLO3)
+    // positive CALXT values add XT cycles, which makes the RTC run faster
+    CLKGEN->CLKKEY = CLKGEN_CLKKEY_CLKKEY_Key;
+    CLKGEN->CALXT = (uint32_t)trim & CLKGEN_CALXT_CALXT_Msk;
+    CLKGEN->CLKKEY = 0;
+#endif
+}
+
+int rtc_hal_trim()
+{
+    return s_trim;
+}
+
+bool rtc_hal_trimChanged()
+{
+    const bool changed = s_trimChanged;
+    s_trimChanged = false;
+    return changed;
+}
+
 void rtc_hal_update()
 {
     g_rtc.getTime();
@@ -73,10 +245,13 @@ void rtc_hal_setTime(int h, int m, int s)
     rtc_hal_update();
 
 #ifdef UseDS3232
-    // Set the DS3231 to the current displayed time
-    BackupClock.setHour(h);
-    BackupClock.setMinute(m);
-    BackupClock.setSecond(s);
+    // Set the DS3231 to the current displayed time, see rtc_hal_service()
+    s_backupWritePending = true;
+
+    // the offset between the clocks just changed, so the drift baseline
+    // is no longer meaningful
+    s_drift.Reset();
+    s_driftState = DRIFT_IDLE;
 #endif
 }
 
@@ -84,4 +259,10 @@ void rtc_hal_setDate(int d, int m, int y)
 {
     g_rtc.setTime(g_rtc.hour, g_rtc.minute, g_rtc.seconds, 0, d, m, y);
     rtc_hal_update();
+
+#ifdef UseDS3232
+    s_backupWritePending = true;
+    s_drift.Reset();
+    s_driftState = DRIFT_IDLE;
+#endif
 }
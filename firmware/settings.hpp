@@ -1,6 +1,8 @@
 #pragma once
 #include <EEPROM.h>
 
+#include "settings_journal.hpp"
+
 // Note: If adding new settings, ALWAYS ADD AT THE END OF THE LIST.
 // Otherwise, settings will be loaded from the wrong location and have
 // the wrong value
@@ -16,6 +18,7 @@ enum SettingNames_e
     SETTING_24_HOUR_MODE,
     SETTING_FLIP_DISPLAY,
     SETTING_TRANSITION_TYPE,
+    SETTING_RTC_TRIM, // signed, stored as uint16_t
 
     // Add new settings here
 
@@ -23,29 +26,95 @@ enum SettingNames_e
     TOTAL_SETTINGS,
 };
 
+// The layout settings are stored in. Every value fits in 16 bits, and the
+// number of values is stored so that settings added at the end of the list
+// simply start out at their defaults. Bump SCHEMA_VERSION and add a case to
+// Settings::Migrate() for any other change.
+struct SettingsRecord
+{
+    uint8_t version;
+    uint8_t count;
+    uint16_t values[TOTAL_SETTINGS];
+};
+
+class Settings;
+
+// Consumers on the hot path keep the values they derive from the settings
+// (colors, lookup tables and such) and register one of these to rebuild
+// them when a setting changes, instead of calling Settings::Get() for every
+// pixel. Use Bind() to point it at a member function.
+struct SettingsListener
+{
+    void (*func)(void *context, const Settings &settings){nullptr};
+    void *context{nullptr};
+
+    template <typename T, void (T::*Method)(const Settings &settings)>
+    static SettingsListener Bind(T &object)
+    {
+        SettingsListener listener;
+        listener.func = [](void *context, const Settings &settings) { (static_cast<T *>(context)->*Method)(settings); };
+        listener.context = &object;
+        return listener;
+    }
+};
+
 // The purpose of this class is to store user configurable settings
-// into EEPROM (including emulated EEPROM stored in flash), only storing
-// when all values have been updated to save write cycles when possible.
+// in flash, only storing when all values have been updated to save write
+// cycles when possible. The settings are kept as one small SettingsRecord,
+// and a copy of it is appended to a SettingsJournal for every change.
 //
-// For simplicity, every value stored will be a uint32_t, restricting us
-// to 256 total settings.
+// Writes are also deferred: Save() only schedules a commit, which Update()
+// performs once the settings have stopped changing for a little while.
+// A burst of button presses therefore costs a single write, and nothing
+// is written at all if the values end up the same as what's stored.
+// The commit itself is split into small steps, one per Update(), so a save
+// never holds up the display for more than a single flash operation.
 class Settings
 {
+  public:
+    enum
+    {
+        // the LEDs, the blinkers, and two animators while one replaces
+        // the other, with room to spare
+        MAX_LISTENERS = 6,
+    };
+
   private:
     enum
     {
-        SETTINGS_SIZE = 256, // 256 4-byte values, 1024 bytes total on Artemis
+        // 1: one uint32_t per setting, as a block in emulated EEPROM
+        // 2: SettingsRecord
+        SCHEMA_VERSION = 2,
+
+        COMMIT_DELAY = 2000, // ms without changes before writing to flash
     };
 
-    uint32_t m_storage[SETTINGS_SIZE] = {0};
+    static_assert(sizeof(SettingsRecord) <= SettingsJournal::MAX_RECORD_WORDS * sizeof(uint32_t),
+                  "SettingsRecord doesn't fit in a journal record");
+
+    SettingsRecord m_record{};
+    SettingsJournal m_journal{&m_record, sizeof(m_record)};
+
+    bool m_commitPending{false};
+    bool m_committing{false};
+    uint32_t m_lastChange{0};
+
+    // The brownout interrupt can arrive in the middle of a Step(), and
+    // mustn't start another one on top of it. It leaves the flush to
+    // Update() instead, right after the step it interrupted.
+    volatile bool m_stepping{false};
+    volatile bool m_flushRequested{false};
+
+    SettingsListener m_listeners[MAX_LISTENERS];
 
   public:
     Settings()
     {
-        Load();
+        Instance() = this;
 
-        // This happens on a new board since the EEPROM has never been written.
-        if (Get(SETTING_DIGIT_TYPE) > DT_PIXELS)
+        // This happens on a new board since nothing has ever been written,
+        // or if what's stored is damaged.
+        if (!Load())
         {
             Reset();
         }
@@ -53,6 +122,16 @@ class Settings
 
     void Reset()
     {
+        SetDefaults();
+        Save();
+        Flush();
+    }
+
+    void SetDefaults()
+    {
+        m_record.version = SCHEMA_VERSION;
+        m_record.count = TOTAL_SETTINGS;
+
         Set(SETTING_DIGIT_TYPE, 1); // 1 is edge lit (acrylics), 2 is pixel display
         Set(SETTING_CUR_BRIGHTNESS, 64);
         Set(SETTING_MIN_BRIGHTNESS, 4);
@@ -63,38 +142,221 @@ class Settings
         Set(SETTING_24_HOUR_MODE, 0);
         Set(SETTING_FLIP_DISPLAY, 0);
         Set(SETTING_TRANSITION_TYPE, 1);
-
-        Save();
+        Set(SETTING_RTC_TRIM, 0);
     }
 
-    // only call after all settings have been updated
+    // Call after settings have been updated. The commit happens later, from
+    // Update(), once there haven't been any changes for COMMIT_DELAY.
     void Save()
     {
-#ifdef FOXIE_ARTEMIS
-        // for Artemis, we're going to write the entire block at once
-        // to save write cycles
-        const size_t blockSize = SETTINGS_SIZE * sizeof(uint32_t);
-        const size_t maxAllowedSize = blockSize;
-        writeBlockToEEPROM(0, (const uint8_t *)m_storage, blockSize, maxAllowedSize);
-#endif
+        m_commitPending = true;
+        m_lastChange = millis();
+    }
+
+    // call once per loop, between frames
+    void Update()
+    {
+        if (m_commitPending && millis() - m_lastChange >= COMMIT_DELAY)
+        {
+            m_commitPending = false;
+            m_committing = true;
+        }
+
+        if (m_committing)
+        {
+            m_stepping = true;
+            m_committing = m_journal.Step();
+            m_stepping = false;
+        }
+
+        if (m_flushRequested)
+        {
+            Flush();
+        }
+    }
+
+    // true from the time a commit starts until it's completely in flash
+    bool IsCommitting() const
+    {
+        return m_committing;
+    }
+
+    // true while Update() has a commit to start or finish
+    bool HasPendingWork() const
+    {
+        return m_commitPending || m_committing || m_flushRequested;
+    }
+
+    // The millis() time Update() next has something to do, while
+    // HasPendingWork(): the end of COMMIT_DELAY for a commit that's waiting
+    // to start, or right away for one that's underway.
+    uint32_t NextUpdateDue() const
+    {
+        if (m_committing || m_flushRequested)
+        {
+            return millis();
+        }
+        return m_lastChange + COMMIT_DELAY;
+    }
+
+    // Steps left in the current commit, each taking one Update(). Zero when
+    // nothing is being committed.
+    uint16_t CommitStepsRemaining() const
+    {
+        return m_committing ? m_journal.StepsRemaining() : 0;
+    }
+
+    // Commits any pending changes right now, e.g. before power goes away,
+    // finishing a commit that's in progress
+    void Flush()
+    {
+        m_stepping = true;
+        m_commitPending = false;
+        m_committing = false;
+        while (m_journal.Step())
+        {
+        }
+        m_flushRequested = false;
+        m_stepping = false;
+    }
+
+    // For the brownout interrupt, which can't be given an object. Commits
+    // whatever hasn't been written yet while there's still power to do it,
+    // or, when it interrupted a flash operation, has Update() do it as soon
+    // as that's finished.
+    static void FlushFromInterrupt()
+    {
+        Settings *settings = Instance();
+        if (!settings || !(settings->m_commitPending || settings->m_committing))
+        {
+            return;
+        }
+
+        if (settings->m_stepping)
+        {
+            settings->m_flushRequested = true;
+            return;
+        }
+        settings->Flush();
     }
 
     uint32_t Get(const SettingNames_e name) const
     {
-        return m_storage[(const uint32_t)name];
+        return m_record.values[name];
     }
 
+    // values are truncated to 16 bits
     void Set(const SettingNames_e name, const uint32_t value)
     {
-        m_storage[(const uint32_t)name] = value;
+        if (m_record.values[name] != (uint16_t)value)
+        {
+            m_record.values[name] = value;
+            Notify();
+        }
+    }
+
+    // The listener is called right away, and then after every change until
+    // it's removed. There's room for MAX_LISTENERS of them; returns false,
+    // without calling it, if they're all taken. The caller then has to
+    // check Get() itself.
+    [[nodiscard]] bool Subscribe(const SettingsListener listener)
+    {
+        for (SettingsListener &slot : m_listeners)
+        {
+            if (!slot.func)
+            {
+                slot = listener;
+                listener.func(listener.context, *this);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void Unsubscribe(const void *context)
+    {
+        for (SettingsListener &slot : m_listeners)
+        {
+            if (slot.context == context)
+            {
+                slot = SettingsListener();
+            }
+        }
     }
 
   private:
-    void Load()
+    void Notify() const
     {
-        for (size_t i = 0; i < TOTAL_SETTINGS; ++i)
+        for (const SettingsListener &listener : m_listeners)
         {
-            EEPROM.get(i * sizeof(uint32_t), m_storage[i]);
+            if (listener.func)
+            {
+                listener.func(listener.context, *this);
+            }
         }
     }
+
+    bool Load()
+    {
+        SettingsRecord record;
+        if (m_journal.Load(&record))
+        {
+            return Migrate(record);
+        }
+        return LoadV1();
+    }
+
+    // Takes the values from a record that passed its CRC check, converting
+    // them from older layouts as needed
+    bool Migrate(const SettingsRecord &record)
+    {
+        switch (record.version)
+        {
+        case SCHEMA_VERSION:
+        {
+            SetDefaults();
+            const uint8_t count = record.count < TOTAL_SETTINGS ? record.count : TOTAL_SETTINGS;
+            memcpy(m_record.values, record.values, count * sizeof(m_record.values[0]));
+            return true;
+        }
+
+        default:
+            // written by newer firmware, there's no telling what it means
+            return false;
+        }
+    }
+
+    // Settings used to be stored as one block in emulated EEPROM, a uint32_t
+    // for each setting up to SETTING_TRANSITION_TYPE. If that's all there
+    // is, convert it so existing clocks keep their settings, and leave the
+    // ones added since at their defaults. It had no CRC, so an invalid digit
+    // type is the only sign that it was never written.
+    bool LoadV1()
+    {
+        enum
+        {
+            V1_SETTINGS = SETTING_TRANSITION_TYPE + 1,
+        };
+
+        uint32_t values[V1_SETTINGS];
+        EEPROM.get(0, values);
+        if (values[SETTING_DIGIT_TYPE] > DT_PIXELS)
+        {
+            return false;
+        }
+
+        SetDefaults();
+        for (uint8_t i = 0; i < V1_SETTINGS; ++i)
+        {
+            Set((SettingNames_e)i, values[i]);
+        }
+        Flush();
+        return true;
+    }
+
+    static Settings *&Instance()
+    {
+        static Settings *instance = nullptr;
+        return instance;
+    }
 };
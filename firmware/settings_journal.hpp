@@ -0,0 +1,362 @@
+#pragma once
+#include "flash_hal.hpp"
+#include <string.h>
+
+// Stores the settings record in flash as a log instead of rewriting a whole
+// block for every change. Each commit appends a copy of the record to the
+// current page, and only when it fills up is the next page in the ring
+// erased and started with the newest copy. Erases are spread evenly over
+// all of the pages.
+//
+// Page layout, in 32-bit words:
+//   [0] PAGE_MAGIC     [1] sequence number, higher is newer
+//   [2..] copies of the record, each one check word followed by the record
+//
+// The check word holds a tag, the record size and a CRC of the record, so
+// one pass over each copy tells whether it's intact. Copies are read back at
+// the size they were written with, so the log can be followed, and the
+// record loaded, after firmware with a larger or smaller record wrote it.
+// A page's header is written last when it's started, its magic word after
+// the sequence number, so a page only counts once it holds a copy of the
+// record and a sequence number that wasn't cut off. Copies cut off by a
+// power loss fail their check and the previous one is used instead.
+//
+// The journal keeps its own copy of what flash holds, so committing is just
+// a matter of calling Step() until it returns false whenever the record
+// may have changed.
+class SettingsJournal
+{
+  public:
+    enum
+    {
+        MAX_RECORD_WORDS = 8,
+    };
+
+  private:
+    enum
+    {
+        PAGE_MAGIC = 0x466F7852, // "FoxR"
+        HEADER_WORDS = 2,
+        CHECK_WORDS = 1,
+        RECORD_TAG = 0xA5,
+        ERASED = 0xFFFFFFFF,
+    };
+
+    enum
+    {
+        NO_PAGE = -1,
+    };
+
+    enum State_e
+    {
+        STATE_IDLE,
+        STATE_ERASE,    // compaction: erase the next page
+        STATE_COPY,     // compaction: write the record to it
+        STATE_SEQUENCE, // compaction: write the header's sequence number
+        STATE_MAGIC,    // compaction: write the magic word, making the page current
+    };
+
+    const void *m_record;
+    const uint8_t m_size;  // in bytes
+    const uint8_t m_words; // record rounded up to whole words
+    uint32_t m_committed[MAX_RECORD_WORDS] = {0};
+    uint8_t m_committedSize; // in bytes, differs from m_size after a firmware update
+
+    int m_page{NO_PAGE};
+    uint32_t m_sequence{0};
+    uint32_t m_nextWord{0};
+
+    State_e m_state{STATE_IDLE};
+    int m_newPage{NO_PAGE};
+
+  public:
+    SettingsJournal(const void *record, const uint8_t size)
+        : m_record(record), m_size(size), m_words(WordsFor(size)), m_committedSize(size)
+    {
+        // never matches the record, so the first Step() commits it
+        m_committed[0] = ~RecordWord(0);
+    }
+
+    // Copies the newest intact record from flash into record, which must be
+    // the size given to the constructor. A record stored at a different size
+    // is cut off or padded with zeros to fit. Returns false if there isn't
+    // one.
+    bool Load(void *record)
+    {
+        m_page = FindNewestPage();
+        if (m_page == NO_PAGE)
+        {
+            return false;
+        }
+
+        m_sequence = flash_hal_read(m_page, 1);
+        m_nextWord = HEADER_WORDS;
+        bool found = false;
+        while (m_nextWord + CHECK_WORDS <= flash_hal_wordsPerPage())
+        {
+            const uint32_t check = flash_hal_read(m_page, m_nextWord);
+            if (check == ERASED)
+            {
+                break; // end of the log
+            }
+
+            const uint8_t size = StoredSize(check);
+            const uint8_t numWords = WordsFor(size);
+            if (m_nextWord + CHECK_WORDS + numWords > flash_hal_wordsPerPage())
+            {
+                m_nextWord = flash_hal_wordsPerPage(); // no room after it either
+                break;
+            }
+
+            uint32_t words[MAX_RECORD_WORDS];
+            for (uint8_t i = 0; i < numWords; ++i)
+            {
+                words[i] = flash_hal_read(m_page, m_nextWord + CHECK_WORDS + i);
+            }
+            if (check == CheckWord(words, size))
+            {
+                memcpy(m_committed, words, numWords * sizeof(uint32_t));
+                m_committedSize = size;
+                found = true;
+            }
+            m_nextWord += CHECK_WORDS + numWords;
+        }
+
+        if (found)
+        {
+            memset(record, 0, m_size);
+            memcpy(record, m_committed, m_committedSize < m_size ? m_committedSize : m_size);
+        }
+        return found;
+    }
+
+    // Commits are done a piece at a time so they can be spread over several
+    // loops: each call does at most one flash operation, either appending
+    // the record, or erasing a page or writing to it while compacting.
+    // Returns false once there's nothing left to do, or when flash failed,
+    // in which case the commit is retried next time.
+    bool Step()
+    {
+        switch (m_state)
+        {
+        case STATE_IDLE:
+            return Append();
+
+        case STATE_ERASE:
+            if (!flash_hal_erase(m_newPage))
+            {
+                return Abort();
+            }
+            m_state = STATE_COPY;
+            return true;
+
+        case STATE_COPY:
+            // if the record changes after this, it's appended once the page
+            // is current
+            if (!WriteRecord(m_newPage, HEADER_WORDS))
+            {
+                return Abort();
+            }
+            m_state = STATE_SEQUENCE;
+            return true;
+
+        case STATE_SEQUENCE:
+        {
+            const uint32_t sequence = m_sequence + 1;
+            if (!flash_hal_program(m_newPage, 1, &sequence, 1))
+            {
+                return Abort();
+            }
+            m_state = STATE_MAGIC;
+            return true;
+        }
+
+        case STATE_MAGIC:
+        {
+            const uint32_t magic = PAGE_MAGIC;
+            if (!flash_hal_program(m_newPage, 0, &magic, 1))
+            {
+                return Abort();
+            }
+
+            m_page = m_newPage;
+            m_sequence++;
+            m_nextWord = HEADER_WORDS + CHECK_WORDS + m_words;
+            m_state = STATE_IDLE;
+            return true;
+        }
+        }
+        return false;
+    }
+
+    // Starts the next page in the ring with a copy of the record. The work
+    // itself is done by Step().
+    void Compact()
+    {
+        m_newPage = (m_page == NO_PAGE) ? 0 : (m_page + 1) % flash_hal_numPages();
+        m_state = STATE_ERASE;
+    }
+
+    // Roughly how many more Step() calls the current commit needs
+    uint8_t StepsRemaining() const
+    {
+        switch (m_state)
+        {
+        case STATE_ERASE:
+            return 4;
+        case STATE_COPY:
+            return 3;
+        case STATE_SEQUENCE:
+            return 2;
+        case STATE_MAGIC:
+            return 1;
+        default:
+            break;
+        }
+
+        if (!IsChanged())
+        {
+            return 0;
+        }
+        return NeedsCompaction() ? 4 : 1;
+    }
+
+  private:
+    bool Append()
+    {
+        // a record that was changed and then changed back isn't written
+        if (!IsChanged())
+        {
+            return false;
+        }
+
+        if (NeedsCompaction())
+        {
+            Compact();
+            return true;
+        }
+
+        // a failed write may have programmed part of the record, so its
+        // space is used up either way
+        const bool written = WriteRecord(m_page, m_nextWord);
+        m_nextWord += CHECK_WORDS + m_words;
+        return written;
+    }
+
+    bool WriteRecord(const int page, const uint32_t word)
+    {
+        uint32_t buffer[CHECK_WORDS + MAX_RECORD_WORDS];
+        uint32_t *words = buffer + CHECK_WORDS;
+        for (uint8_t i = 0; i < m_words; ++i)
+        {
+            words[i] = RecordWord(i);
+        }
+        buffer[0] = CheckWord(words, m_size);
+
+        if (!flash_hal_program(page, word, buffer, CHECK_WORDS + m_words))
+        {
+            return false;
+        }
+
+        memcpy(m_committed, words, m_words * sizeof(uint32_t));
+        m_committedSize = m_size;
+        return true;
+    }
+
+    // The current page is still the valid one, but the copy on the page that
+    // was being started is lost, so the record has to be written again.
+    bool Abort()
+    {
+        m_state = STATE_IDLE;
+        m_committed[0] = ~RecordWord(0);
+        return false;
+    }
+
+    bool IsChanged() const
+    {
+        if (m_committedSize != m_size)
+        {
+            return true;
+        }
+
+        for (uint8_t i = 0; i < m_words; ++i)
+        {
+            if (RecordWord(i) != m_committed[i])
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool NeedsCompaction() const
+    {
+        return m_page == NO_PAGE || m_nextWord + CHECK_WORDS + m_words > flash_hal_wordsPerPage();
+    }
+
+    // One word of the record, padded with erased bytes past its end
+    uint32_t RecordWord(const uint8_t index) const
+    {
+        uint32_t word = ERASED;
+        const uint8_t offset = index * sizeof(uint32_t);
+        const uint8_t length = (m_size - offset < (int)sizeof(uint32_t)) ? m_size - offset : sizeof(uint32_t);
+        memcpy(&word, static_cast<const uint8_t *>(m_record) + offset, length);
+        return word;
+    }
+
+    static uint32_t CheckWord(const uint32_t *words, const uint8_t size)
+    {
+        return ((uint32_t)RECORD_TAG << 24) | ((uint32_t)size << 16) | Crc16(words, size);
+    }
+
+    // The size a check word says its record is. When the check word is too
+    // damaged to say, the copy is assumed to be the current size, which is
+    // as good a guess as any for finding the end of the log.
+    uint8_t StoredSize(const uint32_t check) const
+    {
+        const uint8_t size = (check >> 16) & 0xFF;
+        if ((check >> 24) != RECORD_TAG || size == 0 || size > MAX_RECORD_WORDS * sizeof(uint32_t))
+        {
+            return m_size;
+        }
+        return size;
+    }
+
+    static uint8_t WordsFor(const uint8_t size)
+    {
+        return (size + sizeof(uint32_t) - 1) / sizeof(uint32_t);
+    }
+
+    // CRC-16/CCITT-FALSE, a bit at a time since records are tiny
+    static uint16_t Crc16(const void *data, const uint8_t size)
+    {
+        const uint8_t *bytes = static_cast<const uint8_t *>(data);
+        uint16_t crc = 0xFFFF;
+        for (uint8_t i = 0; i < size; ++i)
+        {
+            crc ^= (uint16_t)bytes[i] << 8;
+            for (int bit = 0; bit < 8; ++bit)
+            {
+                crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : (crc << 1);
+            }
+        }
+        return crc;
+    }
+
+    static int FindNewestPage()
+    {
+        int newest = NO_PAGE;
+        uint32_t newestSequence = 0;
+        for (int page = 0; page < flash_hal_numPages(); ++page)
+        {
+            const uint32_t sequence = flash_hal_read(page, 1);
+            if (flash_hal_read(page, 0) == PAGE_MAGIC && sequence != ERASED &&
+                (newest == NO_PAGE || (int32_t)(sequence - newestSequence) > 0))
+            {
+                newest = page;
+                newestSequence = sequence;
+            }
+        }
+        return newest;
+    }
+};
@@ -0,0 +1,246 @@
+#pragma once
+#include "power_hal.hpp"
+
+// Counters for tuning the main loop, the LED driver and power use, printed
+// over Serial every few seconds along with LatencyTrace's histograms. They
+// are only collected when FOXIE_LATENCY_TRACE is defined (see firmware.ino),
+// otherwise every function here is empty and compiles away.
+
+#ifdef FOXIE_LATENCY_TRACE
+// Says when it's time to print the next report
+class ReportTimer
+{
+  private:
+    enum
+    {
+        REPORT_INTERVAL = 10000, // ms
+    };
+
+    uint32_t m_lastReport{0};
+
+  public:
+    bool Due()
+    {
+        if (millis() - m_lastReport < REPORT_INTERVAL)
+        {
+            return false;
+        }
+        m_lastReport = millis();
+        return true;
+    }
+};
+#endif
+
+// The longest loop, in general and while settings are being written to flash
+class LoopStats
+{
+#ifdef FOXIE_LATENCY_TRACE
+  private:
+    ReportTimer m_report;
+    uint32_t m_loopStart{0};
+    uint32_t m_maxLoop{0};       // us
+    uint32_t m_maxSavingLoop{0}; // us, loops that wrote to flash
+
+  public:
+    // Call at the very end of every loop
+    void LoopDone(const bool saving)
+    {
+        const uint32_t now = micros();
+        const uint32_t duration = now - m_loopStart;
+        if (m_loopStart)
+        {
+            m_maxLoop = duration > m_maxLoop ? duration : m_maxLoop;
+            if (saving)
+            {
+                m_maxSavingLoop = duration > m_maxSavingLoop ? duration : m_maxSavingLoop;
+            }
+        }
+        m_loopStart = now;
+
+        if (m_report.Due())
+        {
+            Serial.print("longest loop us: ");
+            Serial.print(m_maxLoop);
+            Serial.print(", while saving: ");
+            Serial.println(m_maxSavingLoop);
+        }
+    }
+
+    // The processor slept for this long after LoopDone(). It doesn't count
+    // as part of the next loop.
+    void Slept(const uint32_t us)
+    {
+        m_loopStart += us;
+    }
+#else
+  public:
+    void LoopDone(const bool saving)
+    {
+    }
+
+    void Slept(const uint32_t us)
+    {
+    }
+#endif
+};
+
+// What the LED driver reports after each show(): the longest it kept
+// interrupts off, frames it had to start over, how far its bit loop is from
+// the timing model, and how many bytes a frame sends on average
+class LedStats
+{
+#ifdef FOXIE_LATENCY_TRACE
+  private:
+    ReportTimer m_report;
+    uint32_t m_maxInterruptsOff{0}; // us
+    uint16_t m_resends{0};
+    int16_t m_bitLoopError{0};   // cycles, see Adafruit_NeoPixel::getBitLoopError()
+    uint32_t m_bytesSent{0};     // in total...
+    uint32_t m_reportedBytes{0}; // ...and at the last report
+    uint32_t m_frames{0};        // since the last report
+
+  public:
+    // the LED driver's getMaxInterruptsOff(), getResends(),
+    // getBitLoopError() and getBytesSent() after each show()
+    void Transmitted(const uint32_t maxInterruptsOff, const uint16_t resends, const int16_t bitLoopError,
+                     const uint32_t bytesSent)
+    {
+        m_maxInterruptsOff = maxInterruptsOff;
+        m_resends = resends;
+        m_bitLoopError = bitLoopError;
+        m_bytesSent = bytesSent;
+        ++m_frames;
+
+        if (m_report.Due())
+        {
+            Report();
+        }
+    }
+
+  private:
+    void Report()
+    {
+        Serial.print("longest LED interrupts off us: ");
+        Serial.print(m_maxInterruptsOff);
+        Serial.print(", frames resent: ");
+        Serial.println(m_resends);
+
+        // a few either way is the cycle counter's own overhead; more means
+        // the LED bit timings are off
+        Serial.print("LED first byte cycles beyond the timing model: ");
+        Serial.println(m_bitLoopError);
+
+        Serial.print("LED bytes sent per loop: ");
+        Serial.println((m_bytesSent - m_reportedBytes) / m_frames);
+        m_reportedBytes = m_bytesSent;
+        m_frames = 0;
+    }
+#else
+  public:
+    void Transmitted(const uint32_t maxInterruptsOff, const uint16_t resends, const int16_t bitLoopError,
+                     const uint32_t bytesSent)
+    {
+    }
+#endif
+};
+
+// For each animation, how much of the time the processor spent in each
+// power state, and an estimate of the processor current that works out to
+class PowerStats
+{
+  public:
+    enum
+    {
+        // Processor current in each power state, in uA. These are estimates,
+        // not measurements: the Apollo3 datasheet's 6uA/MHz at 48MHz while
+        // awake, and guesses for normal sleep with the clocks still running
+        // and deep sleep with only the HFRC kept on for the STIMER. The LEDs
+        // and the rest of the board aren't included.
+        AWAKE_UA_ESTIMATE = 290,
+        SLEEP_UA_ESTIMATE = 100,
+        DEEP_SLEEP_UA_ESTIMATE = 25,
+    };
+
+    static uint16_t EstimatedCurrent(const PowerState_e state)
+    {
+        static const uint16_t currents[TOTAL_POWER_STATES] = {AWAKE_UA_ESTIMATE, SLEEP_UA_ESTIMATE,
+                                                              DEEP_SLEEP_UA_ESTIMATE};
+        return currents[state];
+    }
+
+#ifdef FOXIE_LATENCY_TRACE
+  private:
+    enum
+    {
+        // time is kept for animations below this, see AnimationType_e
+        TOTAL_MODES = 16,
+    };
+
+    ReportTimer m_report;
+    uint32_t m_awakeSince{0};
+    uint32_t m_time[TOTAL_MODES][TOTAL_POWER_STATES] = {}; // us since the last report
+
+  public:
+    // Call at the very end of every loop, with the animation being shown
+    void LoopDone(const uint8_t mode)
+    {
+        const uint32_t now = micros();
+        if (m_awakeSince)
+        {
+            m_time[mode % TOTAL_MODES][POWER_AWAKE] += now - m_awakeSince;
+        }
+        m_awakeSince = now;
+
+        if (m_report.Due())
+        {
+            Report();
+        }
+    }
+
+    // The processor slept for this long after LoopDone(), in the given state
+    void Slept(const uint8_t mode, const PowerState_e state, const uint32_t us)
+    {
+        m_time[mode % TOTAL_MODES][state] += us;
+        m_awakeSince += us;
+    }
+
+  private:
+    void Report()
+    {
+        for (int mode = 0; mode < TOTAL_MODES; ++mode)
+        {
+            uint32_t total = 0;
+            uint64_t charge = 0;
+            for (int state = 0; state < TOTAL_POWER_STATES; ++state)
+            {
+                total += m_time[mode][state];
+                charge += (uint64_t)m_time[mode][state] * EstimatedCurrent((PowerState_e)state);
+            }
+
+            if (total)
+            {
+                Serial.print("animation ");
+                Serial.print(mode);
+                Serial.print(" per mille awake/sleep/deep sleep:");
+                for (int state = 0; state < TOTAL_POWER_STATES; ++state)
+                {
+                    Serial.print(state ? "/" : " ");
+                    Serial.print((uint32_t)((uint64_t)m_time[mode][state] * 1000 / total));
+                    m_time[mode][state] = 0;
+                }
+                Serial.print(", estimated processor uA: ");
+                Serial.println((uint32_t)(charge / total));
+            }
+        }
+    }
+#else
+  public:
+    void LoopDone(const uint8_t mode)
+    {
+    }
+
+    void Slept(const uint8_t mode, const PowerState_e state, const uint32_t us)
+    {
+    }
+#endif
+};
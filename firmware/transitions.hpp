@@ -0,0 +1,197 @@
+#pragma once
+#include "digit.hpp"
+#include "easing.hpp"
+
+// stored in SETTING_TRANSITION_TYPE
+enum TransitionType_e
+{
+    TRANSITION_NONE = 0,
+    TRANSITION_FADE,
+    TRANSITION_ROLL,
+    TRANSITION_DISSOLVE,
+    TRANSITION_SLIDE,
+
+    TRANSITION_TOTAL,
+};
+
+// Draws a digit on its way from one number to the next. Animators decide
+// when a digit transitions and for how long, and the transition decides
+// what it looks like, so any animator can be used with any transition.
+//
+// Each Draw() clears the digit and then displays at most two numbers, so a
+// frame never costs more than twice what showing the numbers normally does.
+// The old number goes on LAYER_TRANSITION, so the two combine rather than
+// one overwriting the other where they share pixels.
+class Transition
+{
+  public:
+    virtual ~Transition()
+    {
+    }
+
+    // phase goes from 0 at the start of the transition to 255 at the end
+    virtual void Draw(Digit &digit, const uint8_t from, const uint8_t to, const uint8_t phase) const = 0;
+};
+
+class TransitionNone : public Transition
+{
+  public:
+    virtual void Draw(Digit &digit, const uint8_t from, const uint8_t to, const uint8_t phase) const override
+    {
+        digit.AllOff();
+        digit.Display(to);
+    }
+};
+
+// the old number fades out while the new one fades in, where the digits
+// are able to show both at once
+class TransitionFade : public Transition
+{
+  public:
+    virtual void Draw(Digit &digit, const uint8_t from, const uint8_t to, const uint8_t phase) const override
+    {
+        const uint8_t eased = Ease<EaseSine>(phase);
+
+        digit.AllOff();
+        digit.UseLayer(LAYER_TRANSITION);
+        digit.SetBrightness(255 - eased);
+        digit.Display(from);
+        digit.UseLayer(LAYER_DIGITS);
+        digit.SetBrightness(digit.CanCrossfade() ? eased : 255);
+        digit.Display(to);
+        digit.SetBrightness(255);
+    }
+};
+
+// counts up through the numbers in between, all the way around if the
+// number didn't change, on any kind of digit. AnimatorZippy always uses it.
+class TransitionCount : public Transition
+{
+  public:
+    virtual void Draw(Digit &digit, const uint8_t from, const uint8_t to, const uint8_t phase) const override
+    {
+        uint8_t steps = (to + 10 - from) % 10;
+        if (steps == 0)
+        {
+            steps = 10;
+        }
+
+        digit.AllOff();
+        digit.Display((from + steps * Ease<EaseInOutCubic>(phase) / 256) % 10);
+    }
+};
+
+// counts through the numbers in between like TransitionCount on digits
+// with a pixel grid. Digits without one fade instead.
+class TransitionRoll : public TransitionFade
+{
+  private:
+    const TransitionCount m_count;
+
+  public:
+    virtual void Draw(Digit &digit, const uint8_t from, const uint8_t to, const uint8_t phase) const override
+    {
+        if (!digit.HasPixelGrid())
+        {
+            TransitionFade::Draw(digit, from, to, phase);
+            return;
+        }
+
+        m_count.Draw(digit, from, to, phase);
+    }
+};
+
+// pixels switch from the old number to the new one in a scattered order
+class TransitionDissolve : public Transition
+{
+  private:
+    // the phase at which each pixel of the digit switches over
+    const uint8_t THRESHOLDS[Digit::LEDS_PER_DIGIT] = {
+        // clang-format off
+        108, 204,  24, 156,
+        240,  60, 180,  96,
+          0, 132, 228,  48,
+        168, 120,  12, 216,
+         72, 192, 144,  36,
+        // clang-format on
+    };
+
+  public:
+    virtual void Draw(Digit &digit, const uint8_t from, const uint8_t to, const uint8_t phase) const override
+    {
+        const uint8_t eased = Ease<EaseIn>(phase);
+        uint32_t switched = 0;
+        for (int i = 0; i < Digit::LEDS_PER_DIGIT; ++i)
+        {
+            if (eased >= THRESHOLDS[i])
+            {
+                switched |= 1UL << i;
+            }
+        }
+
+        digit.AllOff();
+        digit.UseLayer(LAYER_TRANSITION);
+        digit.SetMask(~switched & Digit::ALL_PIXELS);
+        digit.Display(from);
+        digit.UseLayer(LAYER_DIGITS);
+        digit.SetMask(switched);
+        digit.Display(to);
+        digit.SetMask(Digit::ALL_PIXELS);
+    }
+};
+
+// the old number moves up and out while the new one comes in from below.
+// Digits without a pixel grid fade instead.
+class TransitionSlide : public TransitionFade
+{
+  private:
+    enum
+    {
+        ROWS = Digit::LEDS_PER_DIGIT / Digit::LEDS_PER_ROW,
+    };
+
+  public:
+    virtual void Draw(Digit &digit, const uint8_t from, const uint8_t to, const uint8_t phase) const override
+    {
+        if (!digit.HasPixelGrid())
+        {
+            TransitionFade::Draw(digit, from, to, phase);
+            return;
+        }
+
+        const int rows = (ROWS * Ease<EaseOutBounce>(phase) + 128) / 256;
+
+        digit.AllOff();
+        digit.UseLayer(LAYER_TRANSITION);
+        digit.SetRowOffset(-rows);
+        digit.Display(from);
+        digit.UseLayer(LAYER_DIGITS);
+        digit.SetRowOffset(ROWS - rows);
+        digit.Display(to);
+        digit.SetRowOffset(0);
+    }
+};
+
+// Transitions don't have any state, so there's only ever one of each
+static inline const Transition &GetTransition(const TransitionType_e type)
+{
+    static const TransitionNone none;
+    static const TransitionFade fade;
+    static const TransitionRoll roll;
+    static const TransitionDissolve dissolve;
+    static const TransitionSlide slide;
+
+    switch (type)
+    {
+    case TRANSITION_FADE:
+        return fade;
+    case TRANSITION_ROLL:
+        return roll;
+    case TRANSITION_DISSOLVE:
+        return dissolve;
+    case TRANSITION_SLIDE:
+        return slide;
+    default:
+        return none;
+    }
+}
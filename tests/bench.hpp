@@ -0,0 +1,33 @@
+#pragma once
+#include <chrono>
+#include <stdio.h>
+
+// Host timings only say how the cases compare with each other, not how long
+// they take on the Artemis. Each case runs a few times and the fastest run
+// counts, which is the one least disturbed by everything else on the host.
+
+template <typename Func> static double NsPer(const long iterations, Func func)
+{
+    double best = 0;
+    for (int run = 0; run < 5; ++run)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        for (long i = 0; i < iterations; ++i)
+        {
+            func(i);
+        }
+        const std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+        const double ns = elapsed.count() / iterations;
+        if (run == 0 || ns < best)
+        {
+            best = ns;
+        }
+    }
+    return best;
+}
+
+// keeps the compiler from optimizing away work whose result isn't used
+template <typename T> static void KeepResult(const T &value)
+{
+    asm volatile("" : : "g"(&value) : "memory");
+}
@@ -0,0 +1,143 @@
+// What a frame of the scripted animations costs, against the native
+// AnimatorRainbow and AnimatorGlow they replaced (copied here from before
+// animation_vm.hpp), and against a program that never yields, which is cut
+// off after MAX_STEPS_PER_FRAME instructions. Each case ends with the six
+// digit colors, like DoColorChanges() before it sets them.
+#include "host_config.hpp"
+#include <memory>
+
+#include "animator.hpp"
+#include "bench.hpp"
+
+static int ScaleBrightness(const int color, const float brightness)
+{
+    const float r = ((color & 0xFF0000) >> 16) * brightness;
+    const float g = ((color & 0x00FF00) >> 8) * brightness;
+    const float b = (color & 0x0000FF) * brightness;
+    return Adafruit_NeoPixel::Color(r, g, b);
+}
+
+struct NativeRainbow
+{
+    float colors[NUM_DIGITS] = {0, 12, 24, 36, 48, 60};
+
+    void Frame(uint32_t *out)
+    {
+        for (int i = NUM_DIGITS - 1; i >= 0; --i)
+        {
+            colors[i] += 0.1f;
+            if (colors[i] > 255.0f)
+            {
+                colors[i] -= 255.0f;
+            }
+            out[i] = ColorWheel(colors[i]);
+        }
+    }
+};
+
+struct NativeGlow
+{
+    float brightness{1.0f};
+    float incrementer{0.1f};
+    uint8_t wheelColor{40};
+
+    // every frame is one that changes the brightness, as at the 25ms interval
+    void Frame(uint32_t *out)
+    {
+        const int scaledColor = ScaleBrightness(ColorWheel(wheelColor), brightness);
+        for (int i = 0; i < NUM_DIGITS; ++i)
+        {
+            out[i] = scaledColor;
+        }
+
+        brightness += incrementer;
+        if (brightness > 1.0f)
+        {
+            incrementer = -0.025f;
+            brightness = 1.0f;
+        }
+        else if (brightness < 0.4f)
+        {
+            incrementer = 0.025f;
+            brightness = 0.4f;
+        }
+    }
+};
+
+// The most an animation can cost: the most expensive instructions, looping
+// without a yield
+static const uint8_t PROGRAM_WORST_CASE[] = {
+    AnimationVm::OP_IN,     1, AnimationVm::IN_MILLIS,
+    AnimationVm::OP_SIN,    0, 1,
+    AnimationVm::OP_COLOR,  AnimationVm::ALL_DIGITS, 0,
+    AnimationVm::OP_BRIGHT, AnimationVm::ALL_DIGITS, 1,
+    AnimationVm::OP_JMP,    0,
+};
+
+static const AnimationProgram &Program(const AnimationType_e type)
+{
+    for (const AnimationProgram &program : ANIMATION_PROGRAMS)
+    {
+        if (program.type == type)
+        {
+            return program;
+        }
+    }
+    abort();
+}
+
+static double ScriptNs(const uint8_t *code, const uint8_t length)
+{
+    AnimationVm vm;
+    for (int i = 0; i < NUM_DIGITS; ++i)
+    {
+        vm.wheel[i] = 40;
+        vm.brightness[i] = 255;
+    }
+    vm.Load(code, length);
+
+    uint32_t out[NUM_DIGITS];
+    return NsPer(20000, [&](const long i) {
+        vm.inputs[AnimationVm::IN_MILLIS] = i * 16;
+        vm.inputs[AnimationVm::IN_MS] = (i * 16) % 1000;
+        vm.inputs[AnimationVm::IN_SECOND] = (i * 16 / 1000) % 60;
+        vm.inputs[AnimationVm::IN_WHEEL] = 40;
+        vm.RunFrame();
+        for (int d = 0; d < NUM_DIGITS; ++d)
+        {
+            out[d] = ColorScale(ColorWheel(vm.wheel[d]), vm.brightness[d]);
+        }
+        KeepResult(out);
+    });
+}
+
+template <typename Native> static double NativeNs()
+{
+    Native native;
+    uint32_t out[NUM_DIGITS];
+    return NsPer(20000, [&](const long) {
+        native.Frame(out);
+        KeepResult(out);
+    });
+}
+
+int main()
+{
+    const AnimationProgram &rainbow = Program(ANIM_RAINBOW);
+    const AnimationProgram &glow = Program(ANIM_GLOW);
+
+    const double nativeRainbow = NativeNs<NativeRainbow>();
+    const double nativeGlow = NativeNs<NativeGlow>();
+    const double scriptRainbow = ScriptNs(rainbow.code, rainbow.length);
+    const double scriptGlow = ScriptNs(glow.code, glow.length);
+    const double worstCase = ScriptNs(PROGRAM_WORST_CASE, sizeof(PROGRAM_WORST_CASE));
+
+    printf("%-22s %10s %10s\n", "animation", "frame ns", "vs native");
+    printf("%-22s %10.0f\n", "native rainbow", nativeRainbow);
+    printf("%-22s %10.0f %9.2fx\n", "script rainbow", scriptRainbow, scriptRainbow / nativeRainbow);
+    printf("%-22s %10.0f\n", "native glow", nativeGlow);
+    printf("%-22s %10.0f %9.2fx\n", "script glow", scriptGlow, scriptGlow / nativeGlow);
+    printf("%-22s %10.0f %9.2fx\n", "script, never yields", worstCase, worstCase / nativeRainbow);
+    printf("(%d instructions a frame at most)\n", AnimationVm::MAX_STEPS_PER_FRAME);
+    return 0;
+}
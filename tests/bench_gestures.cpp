@@ -0,0 +1,114 @@
+// What dispatching a gesture's action costs: the engine's Handler against
+// the other ways it could call the owner, and a whole tap going through
+// GestureEngine::Update() with a table the size of the clock's
+#include "host_config.hpp"
+#include <functional>
+
+#include "bench.hpp"
+#include "gestures.hpp"
+
+class Owner
+{
+  public:
+    uint32_t sum{0};
+
+    void OnAction(const uint8_t action)
+    {
+        sum += action;
+    }
+};
+
+class Listener
+{
+  public:
+    virtual void OnAction(const uint8_t action) = 0;
+};
+
+class VirtualOwner : public Listener
+{
+  public:
+    uint32_t sum{0};
+
+    virtual void OnAction(const uint8_t action) override
+    {
+        sum += action;
+    }
+};
+
+enum
+{
+    STATE_A = 1,
+    STATE_B = 2,
+};
+
+static const GestureBinding BINDINGS[] = {
+    {STATE_A, BTN_BIT_H, GESTURE_TAP, 0, 1},
+    {STATE_A, BTN_BIT_M, GESTURE_TAP, 0, 2},
+    {STATE_A, BTN_BIT_C, GESTURE_TAP, 0, 3},
+    {STATE_A, BTN_BIT_B, GESTURE_TAP, 0, 4},
+    {STATE_A, BTN_BIT_H, GESTURE_REPEAT, 100, 5},
+    {STATE_A, BTN_BIT_M, GESTURE_REPEAT, 100, 6},
+    {STATE_A, BTN_BIT_H | BTN_BIT_M, GESTURE_HOLD, 2000, 7},
+    {STATE_A, BTN_BIT_C, GESTURE_DOUBLE_TAP, 0, 8},
+    {STATE_B, BTN_BIT_H, GESTURE_PRESS, 0, 9},
+    {STATE_B, BTN_BIT_M, GESTURE_PRESS, 0, 10},
+    {STATE_A | STATE_B, BTN_BIT_B, GESTURE_HOLD, 1000, 11},
+    {STATE_A | STATE_B, BTN_BIT_B, GESTURE_RELEASE, 0, 12},
+};
+
+int main()
+{
+    Owner owner;
+    VirtualOwner virtualOwner;
+    GestureEngine::Handler handler = GestureEngine::Bind<Owner, &Owner::OnAction>(owner);
+    std::function<void(uint8_t)> function = [&owner](const uint8_t action) { owner.OnAction(action); };
+    Listener *listener = &virtualOwner;
+
+    // KeepResult() on each callee makes the compiler load it every time,
+    // like the engine does from its member
+    const double directNs = NsPer(1000000, [&](const long i) {
+        Owner *target = &owner;
+        KeepResult(target);
+        target->OnAction(i);
+    });
+    const double handlerNs = NsPer(1000000, [&](const long i) {
+        KeepResult(handler);
+        handler.func(handler.context, i);
+    });
+    const double virtualNs = NsPer(1000000, [&](const long i) {
+        KeepResult(listener);
+        listener->OnAction(i);
+    });
+    const double functionNs = NsPer(1000000, [&](const long i) {
+        KeepResult(function);
+        function(i);
+    });
+    KeepResult(owner.sum);
+    KeepResult(virtualOwner.sum);
+
+    printf("%-22s %10s\n", "dispatch", "ns");
+    printf("%-22s %10.2f\n", "direct member call", directNs);
+    printf("%-22s %10.2f\n", "GestureEngine::Handler", handlerNs);
+    printf("%-22s %10.2f\n", "virtual", virtualNs);
+    printf("%-22s %10.2f\n", "std::function", functionNs);
+
+    // press C and release it, a tap, which fires through the whole table
+    GestureEngine engine;
+    engine.SetBindings(BINDINGS);
+    engine.handler = handler;
+    uint32_t now = 0;
+    const double tapNs = NsPer(100000, [&](const long) {
+        engine.Update(BTN_BIT_C, STATE_A, now);
+        now += GestureEngine::DEBOUNCE_TIME;
+        engine.Update(BTN_BIT_C, STATE_A, now);
+        now += 50;
+        engine.Update(0, STATE_A, now);
+        now += GestureEngine::DEBOUNCE_TIME;
+        engine.Update(0, STATE_A, now);
+        now += GestureEngine::DOUBLE_TAP_TIME + 1;
+    });
+    KeepResult(owner.sum);
+    printf("%-22s %10.2f (%d bindings)\n", "tap through Update()", tapNs,
+           (int)(sizeof(BINDINGS) / sizeof(BINDINGS[0])));
+    return 0;
+}
@@ -0,0 +1,37 @@
+// What the LEDs are sent in an hour of each animation, with each kind of
+// digits, the right way up and flipped: the bytes and the time on the wire,
+// next to the time whole frames would take. Simulates a minute and scales
+// it up, unless given how many seconds to simulate.
+#include "clock_sim.hpp"
+
+#include <stdlib.h>
+
+int main(int argc, char **argv)
+{
+    const uint32_t seconds = argc > 1 ? atoi(argv[1]) : 60;
+    const double perHour = 3600.0 / seconds;
+    // 3 bytes per LED, 10us each
+    const double fullFrameMs = NUM_LEDS * 3 * 10 / 1000.0;
+
+    printf("per hour, from %u seconds simulated\n", (unsigned)seconds);
+    printf("%-9s %-5s %-4s %9s %9s %10s %10s %8s\n", "animation", "type", "flip", "frames", "KB sent", "sending ms",
+           "full ms", "saved");
+    for (int type = DT_EDGE_LIT; type <= DT_PIXELS; ++type)
+    {
+        for (int flipped = 0; flipped <= 1; ++flipped)
+        {
+            for (int animation = 0; animation < ANIM_USER_ACCESSIBLE_TOTAL; ++animation)
+            {
+                const ClockRun run =
+                    RunClock(seconds, (DigitTypes_e)type, (AnimationType_e)animation, flipped, true);
+                const double sendingMs = run.sendingUs / 1000.0 * perHour;
+                const double fullMs = run.frames * fullFrameMs * perHour;
+                printf("%-9s %-5s %-4d %9.0f %9.1f %10.0f %10.0f %7.1f%%\n", ANIMATION_NAMES[animation],
+                       type == DT_EDGE_LIT ? "edge" : "pxl", flipped, run.frames * perHour,
+                       run.bytesSent / 1024.0 * perHour, sendingMs, fullMs,
+                       fullMs ? 100 - sendingMs * 100 / fullMs : 0.0);
+            }
+        }
+    }
+    return 0;
+}
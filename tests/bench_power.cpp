@@ -0,0 +1,50 @@
+// How the processor spends an hour of each animation, with each kind of
+// digits: the share of the time awake and in each sleep state, first with
+// normal sleep only and then with deep sleep too, and the charge that works
+// out to with PowerStats' estimated currents. Simulates a minute and scales
+// it up, unless given how many seconds to simulate.
+#include "clock_sim.hpp"
+
+#include <stdlib.h>
+
+// uAh in an hour, which is also the average current in uA
+static double EstimatedCharge(const ClockRun &run)
+{
+    double charge = 0;
+    for (int state = 0; state < TOTAL_POWER_STATES; ++state)
+    {
+        charge += (double)run.time[state] * PowerStats::EstimatedCurrent((PowerState_e)state) / run.Total();
+    }
+    return charge;
+}
+
+static double Percent(const ClockRun &run, const PowerState_e state)
+{
+    return run.time[state] * 100.0 / run.Total();
+}
+
+int main(int argc, char **argv)
+{
+    const uint32_t seconds = argc > 1 ? atoi(argv[1]) : 60;
+
+    printf("processor only, from %u seconds simulated, estimated uA awake/sleep/deep sleep: %u/%u/%u\n",
+           (unsigned)seconds, PowerStats::EstimatedCurrent(POWER_AWAKE), PowerStats::EstimatedCurrent(POWER_SLEEP),
+           PowerStats::EstimatedCurrent(POWER_DEEP_SLEEP));
+    printf("%-24s | %-23s | %s\n", "", "normal sleep only", "with deep sleep");
+    printf("%-9s %-5s %8s | %6s %6s %9s | %6s %6s %6s %9s\n", "animation", "type", "loops/s", "awake", "sleep",
+           "uAh/h", "awake", "sleep", "deep", "uAh/h");
+    for (int type = DT_EDGE_LIT; type <= DT_PIXELS; ++type)
+    {
+        for (int animation = 0; animation < ANIM_USER_ACCESSIBLE_TOTAL; ++animation)
+        {
+            const ClockRun normal = RunClock(seconds, (DigitTypes_e)type, (AnimationType_e)animation, false, false);
+            const ClockRun deep = RunClock(seconds, (DigitTypes_e)type, (AnimationType_e)animation, false, true);
+            printf("%-9s %-5s %8.1f | %5.1f%% %5.1f%% %9.1f | %5.1f%% %5.1f%% %5.1f%% %9.1f\n",
+                   ANIMATION_NAMES[animation], type == DT_EDGE_LIT ? "edge" : "pxl", deep.loops / (double)seconds,
+                   Percent(normal, POWER_AWAKE), Percent(normal, POWER_SLEEP), EstimatedCharge(normal),
+                   Percent(deep, POWER_AWAKE), Percent(deep, POWER_SLEEP), Percent(deep, POWER_DEEP_SLEEP),
+                   EstimatedCharge(deep));
+        }
+    }
+    return 0;
+}
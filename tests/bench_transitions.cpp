@@ -0,0 +1,56 @@
+// What a frame costs with each transition, for a clock with both kinds of
+// digits: drawing all six digits mid-transition, and then compositing them
+// into the LEDs
+#include "host_config.hpp"
+#include <memory>
+
+#include "bench.hpp"
+#include "transitions.hpp"
+
+static const char *const NAMES[TRANSITION_TOTAL] = {"none", "fade", "roll", "dissolve", "slide"};
+
+int main()
+{
+    Adafruit_NeoPixel leds(NUM_LEDS, PIN_FOR_LEDS, NEO_GRB + NEO_KHZ800);
+    Compositor compositor;
+    std::vector<std::shared_ptr<Digit>> digits;
+    for (int i = 0; i < NUM_DIGITS; ++i)
+    {
+        const int color = ColorWheel(i * 40);
+        if (i % 2)
+        {
+            digits.push_back(std::make_shared<PXLDigit>(compositor, i * Digit::LEDS_PER_DIGIT, color));
+        }
+        else
+        {
+            digits.push_back(std::make_shared<EdgeLitDigit>(compositor, i * Digit::LEDS_PER_DIGIT, color));
+        }
+    }
+
+    printf("%-10s %12s %12s %8s\n", "transition", "draw ns", "frame ns", "vs none");
+    double none = 0;
+    for (int type = 0; type < TRANSITION_TOTAL; ++type)
+    {
+        const Transition &transition = GetTransition((TransitionType_e)type);
+        auto draw = [&](const long i) {
+            const uint8_t from = i % 10;
+            const uint8_t phase = i * 7;
+            for (int d = 0; d < NUM_DIGITS; ++d)
+            {
+                transition.Draw(*digits[d], from, (from + d + 1) % 10, phase);
+            }
+        };
+
+        const double drawNs = NsPer(5000, draw);
+        const double frameNs = NsPer(5000, [&](const long i) {
+            draw(i);
+            KeepResult(compositor.Composite(leds));
+        });
+        if (type == TRANSITION_NONE)
+        {
+            none = frameNs;
+        }
+        printf("%-10s %12.0f %12.0f %7.2fx\n", NAMES[type], drawNs, frameNs, frameNs / none);
+    }
+    return 0;
+}
@@ -0,0 +1,28 @@
+#pragma once
+#include <stdio.h>
+
+// CHECK() reports a failure and carries on, so one run shows everything
+// that's wrong. main() returns TestResult().
+
+static int g_failures = 0;
+
+#define CHECK(condition)                                                                                               \
+    do                                                                                                                 \
+    {                                                                                                                  \
+        if (!(condition))                                                                                              \
+        {                                                                                                              \
+            printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition);                                       \
+            ++g_failures;                                                                                              \
+        }                                                                                                              \
+    } while (0)
+
+static inline int TestResult()
+{
+    if (g_failures)
+    {
+        printf("%d checks failed\n", g_failures);
+        return 1;
+    }
+    printf("OK\n");
+    return 0;
+}
@@ -0,0 +1,19 @@
+# Fails if firmware/animation_programs.hpp isn't what tools/animasm.py makes
+# from tools/animations, meaning a program or the VM changed without it
+# being regenerated.
+#
+#   cmake -DPYTHON=python3 -DROOT=<repo> -P check_animation_programs.cmake
+file(GLOB sources ${ROOT}/tools/animations/*.anim)
+execute_process(
+    COMMAND ${PYTHON} ${ROOT}/tools/animasm.py ${sources}
+    OUTPUT_VARIABLE assembled
+    RESULT_VARIABLE result)
+if(NOT result EQUAL 0)
+    message(FATAL_ERROR "tools/animasm.py failed")
+endif()
+
+file(READ ${ROOT}/firmware/animation_programs.hpp committed)
+if(NOT assembled STREQUAL committed)
+    message(FATAL_ERROR "firmware/animation_programs.hpp is out of date, regenerate it with:\n"
+        "  tools/animasm.py tools/animations/*.anim > firmware/animation_programs.hpp")
+endif()
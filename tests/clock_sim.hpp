@@ -0,0 +1,113 @@
+#pragma once
+// The whole clock running against simulated time, for the benchmarks that
+// look at an hour of it: what's sent to the LEDs and how long the processor
+// sleeps. Host time only moves as the clock would spend it on the Artemis.
+// Each loop costs LOOP_US for the work, plus the time its LED data takes on
+// the wire, and the rest is slept away in fake_power.
+#include "host_config.hpp"
+#include <am_hal_gpio.h>
+
+#include "clock.hpp"
+#include "fake_flash.hpp"
+#include "fake_power.hpp"
+#include "rtc_hal.hpp"
+
+static const char *const ANIMATION_NAMES[ANIM_USER_ACCESSIBLE_TOTAL] = {"none",  "zippy",    "glow",
+                                                                        "cycle", "flowleft", "rainbow"};
+
+struct ClockRun
+{
+    enum
+    {
+        // us a loop takes to read the buttons, draw and composite. A guess
+        // at the Artemis's speed, not a measurement.
+        LOOP_US = 1000,
+    };
+
+    uint64_t loops{0};
+    uint64_t frames{0}; // loops that sent anything to the LEDs
+    uint64_t bytesSent{0};
+    uint64_t sendingUs{0}; // on the wire, at 800kHz
+    uint64_t time[TOTAL_POWER_STATES] = {}; // us
+
+    uint64_t Total() const
+    {
+        return time[POWER_AWAKE] + time[POWER_SLEEP] + time[POWER_DEEP_SLEEP];
+    }
+};
+
+// Charges host time for the loop in progress, once, either just before it
+// sleeps or when it ends without sleeping
+static ClockRun *s_run = nullptr;
+static bool s_charged = false;
+static uint32_t s_bitsCharged = 0;
+
+static void ChargeLoop()
+{
+    if (s_charged)
+    {
+        return;
+    }
+    s_charged = true;
+
+    // one rising edge per bit, 1.25us each
+    const uint32_t bits = host_fastGpioSets - s_bitsCharged;
+    s_bitsCharged = host_fastGpioSets;
+    const uint32_t sendingUs = bits * 5 / 4;
+    host_advanceMicros(ClockRun::LOOP_US + sendingUs);
+
+    ++s_run->loops;
+    s_run->frames += bits != 0;
+    s_run->bytesSent += bits / 8;
+    s_run->sendingUs += sendingUs;
+}
+
+// Runs the clock for this long, from 10:00:00, with an animation on one kind
+// of digits and everything else at its default
+static ClockRun RunClock(const uint32_t seconds, const DigitTypes_e type, const AnimationType_e animation,
+                         const bool flipped, const bool deepSleep)
+{
+    fake_flash::Reset();
+    {
+        Settings settings;
+        settings.Set(SETTING_DIGIT_TYPE, type);
+        settings.Set(SETTING_ANIMATION_TYPE, animation);
+        settings.Set(SETTING_FLIP_DISPLAY, flipped);
+        settings.Flush();
+    }
+
+    fake_power::Reset();
+    fake_power::SetDeepSleepUsable(deepSleep);
+    fake_power::SetBeforeSleep(ChargeLoop);
+
+    // a second on from the last run, so the LEDs are ready for a new frame
+    host_advanceMicros(1000000);
+    ClockRun run;
+    s_run = &run;
+    Clock clock;
+    rtc_hal_setTime(10, 0, 0);
+
+    // the first frame sends everything, which says nothing about the rest
+    s_charged = false;
+    clock.Loop();
+    ChargeLoop();
+    run = ClockRun();
+    const uint64_t sleptBefore[TOTAL_POWER_STATES] = {0, fake_power::Slept(POWER_SLEEP),
+                                                      fake_power::Slept(POWER_DEEP_SLEEP)};
+
+    const unsigned long start = micros();
+    while (micros() - start < seconds * 1000000ULL)
+    {
+        s_charged = false;
+        clock.Loop();
+        ChargeLoop();
+    }
+
+    for (int state = POWER_SLEEP; state < TOTAL_POWER_STATES; ++state)
+    {
+        run.time[state] = fake_power::Slept((PowerState_e)state) - sleptBefore[state];
+    }
+    run.time[POWER_AWAKE] = micros() - start - run.time[POWER_SLEEP] - run.time[POWER_DEEP_SLEEP];
+    s_run = nullptr;
+    return run;
+}
@@ -0,0 +1,32 @@
+#define FOXIE_DSP_COLOR_MODEL
+#include "color_kernels.hpp"
+#include "color_kernels_dsp.hpp"
+
+#ifndef FOXIE_DSP_COLOR
+#error The SIMD versions should be built here
+#endif
+
+uint32_t DspColorScale(uint32_t color, uint8_t brightness)
+{
+    return ColorScale(color, brightness);
+}
+
+uint32_t DspColorLerp(uint32_t a, uint32_t b, uint8_t t)
+{
+    return ColorLerp(a, b, t);
+}
+
+uint32_t DspColorAddSaturate(uint32_t a, uint32_t b)
+{
+    return ColorAddSaturate(a, b);
+}
+
+uint32_t DspColorAverage(uint32_t a, uint32_t b)
+{
+    return ColorAverage(a, b);
+}
+
+uint32_t DspColorMax(uint32_t a, uint32_t b)
+{
+    return ColorMax(a, b);
+}
@@ -0,0 +1,10 @@
+#pragma once
+#include <stdint.h>
+
+// The color kernels as built for the Cortex-M4, with models of its SIMD
+// instructions, see color_kernels_dsp.cpp
+uint32_t DspColorScale(uint32_t color, uint8_t brightness);
+uint32_t DspColorLerp(uint32_t a, uint32_t b, uint8_t t);
+uint32_t DspColorAddSaturate(uint32_t a, uint32_t b);
+uint32_t DspColorAverage(uint32_t a, uint32_t b);
+uint32_t DspColorMax(uint32_t a, uint32_t b);
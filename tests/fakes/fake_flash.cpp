@@ -0,0 +1,188 @@
+#include "fake_flash.hpp"
+#include "flash_hal.hpp"
+#include <string.h>
+
+using namespace fake_flash;
+
+static const uint32_t ERASED_WORD = 0xFFFFFFFF;
+
+static uint32_t s_words[PAGES][WORDS_PER_PAGE];
+static uint32_t s_erases[PAGES];
+static bool s_initialized = false;
+static void (*s_isr)() = nullptr;
+static bool s_busy = false;
+static uint32_t s_nested = 0;
+
+enum
+{
+    POWER_ON = -1,
+};
+static long s_unitsLeft = POWER_ON; // 0 once power is cut
+static uint32_t s_random = 1;
+
+void fake_flash::Reset()
+{
+    memset(s_words, 0xFF, sizeof(s_words));
+    memset(s_erases, 0, sizeof(s_erases));
+    s_initialized = true;
+    s_isr = nullptr;
+    s_nested = 0;
+    s_unitsLeft = POWER_ON;
+}
+
+uint32_t fake_flash::EraseCount(int page)
+{
+    return s_erases[page];
+}
+
+void fake_flash::CutPowerAfter(uint32_t units, uint32_t seed)
+{
+    s_unitsLeft = units;
+    s_random = seed | 1;
+}
+
+void fake_flash::RestorePower()
+{
+    s_unitsLeft = POWER_ON;
+}
+
+bool fake_flash::PowerWasCut()
+{
+    return s_unitsLeft == 0;
+}
+
+static uint32_t Random()
+{
+    // xorshift32
+    s_random ^= s_random << 13;
+    s_random ^= s_random >> 17;
+    s_random ^= s_random << 5;
+    return s_random;
+}
+
+// false once there's no power left for another unit
+static bool UsePower()
+{
+    if (s_unitsLeft == POWER_ON)
+    {
+        return true;
+    }
+    if (s_unitsLeft > 0)
+    {
+        --s_unitsLeft;
+    }
+    return s_unitsLeft > 0;
+}
+
+void fake_flash::SetInterrupt(void (*isr)())
+{
+    s_isr = isr;
+}
+
+uint32_t fake_flash::NestedOperations()
+{
+    return s_nested;
+}
+
+// Marks the flash busy for the length of an operation, and runs the
+// interrupt halfway through it
+class Operation
+{
+  public:
+    Operation()
+    {
+        if (!s_initialized)
+        {
+            Reset();
+        }
+        if (s_busy)
+        {
+            ++s_nested;
+        }
+        s_busy = true;
+    }
+
+    ~Operation()
+    {
+        s_busy = false;
+    }
+
+    void Interrupt()
+    {
+        void (*isr)() = s_isr;
+        if (isr)
+        {
+            s_isr = nullptr; // once per operation, not recursively
+            isr();
+            s_isr = isr;
+        }
+    }
+};
+
+int flash_hal_numPages()
+{
+    return PAGES;
+}
+
+uint32_t flash_hal_wordsPerPage()
+{
+    return WORDS_PER_PAGE;
+}
+
+uint32_t flash_hal_read(int page, uint32_t word)
+{
+    if (!s_initialized)
+    {
+        Reset();
+    }
+    return s_words[page][word];
+}
+
+bool flash_hal_program(int page, uint32_t word, const uint32_t *data, uint32_t numWords)
+{
+    Operation operation;
+    if (PowerWasCut())
+    {
+        return false;
+    }
+
+    for (uint32_t i = 0; i < numWords; ++i)
+    {
+        if (i == numWords / 2)
+        {
+            operation.Interrupt();
+        }
+        if (!UsePower())
+        {
+            // torn: some of the bits that should have been cleared weren't
+            s_words[page][word + i] &= data[i] | Random();
+            return false;
+        }
+        s_words[page][word + i] &= data[i];
+    }
+    return true;
+}
+
+bool flash_hal_erase(int page)
+{
+    Operation operation;
+    if (PowerWasCut())
+    {
+        return false;
+    }
+
+    operation.Interrupt();
+    ++s_erases[page];
+    if (!UsePower())
+    {
+        // torn: words are erased, or only have some of their bits set
+        for (uint32_t &word : s_words[page])
+        {
+            const uint32_t random = Random();
+            word = (random & 1) ? ERASED_WORD : word | Random();
+        }
+        return false;
+    }
+    memset(s_words[page], 0xFF, sizeof(s_words[page]));
+    return true;
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include <stdint.h>
+
+// flash_hal.hpp on top of a few pages of RAM that behave like flash:
+// programming can only clear bits, and erasing sets the whole page back to
+// 0xFFFFFFFF.
+namespace fake_flash
+{
+enum
+{
+    PAGES = 4,
+    WORDS_PER_PAGE = 2048, // 8KB, as on the Apollo3
+};
+
+// every page erased, counters cleared
+void Reset();
+
+uint32_t EraseCount(int page);
+
+// Power goes away after this many more words have been programmed or pages
+// erased, in the middle of the operation that gets there. The word being
+// programmed then is left with only some of its bits cleared, and the page
+// being erased with some words erased and the rest somewhere in between,
+// which it's up to the seed what. Until RestorePower(), nothing else is
+// written and every operation fails.
+void CutPowerAfter(uint32_t units, uint32_t seed);
+void RestorePower();
+bool PowerWasCut();
+
+// Called in the middle of every program and erase, like an interrupt that
+// arrives while the flash is busy. Operations started from inside it are
+// counted as nested.
+void SetInterrupt(void (*isr)());
+uint32_t NestedOperations();
+} // namespace fake_flash
@@ -0,0 +1,58 @@
+#include <Arduino.h>
+
+#include "fake_power.hpp"
+#include "fake_rtc.hpp"
+
+static bool s_deepSleepUsable = true;
+static void (*s_beforeSleep)() = nullptr;
+static uint64_t s_slept[TOTAL_POWER_STATES];
+
+void fake_power::Reset()
+{
+    s_deepSleepUsable = true;
+    s_beforeSleep = nullptr;
+    for (uint64_t &slept : s_slept)
+    {
+        slept = 0;
+    }
+}
+
+void fake_power::SetDeepSleepUsable(const bool usable)
+{
+    s_deepSleepUsable = usable;
+}
+
+void fake_power::SetBeforeSleep(void (*hook)())
+{
+    s_beforeSleep = hook;
+}
+
+uint64_t fake_power::Slept(const PowerState_e state)
+{
+    return s_slept[state];
+}
+
+PowerState_e power_hal_sleep(PowerState_e state, uint32_t ms)
+{
+    if (state == POWER_DEEP_SLEEP && !s_deepSleepUsable)
+    {
+        state = POWER_SLEEP;
+    }
+
+    const unsigned long start = micros();
+    if (s_beforeSleep)
+    {
+        s_beforeSleep();
+    }
+    const uint64_t worked = micros() - start;
+
+    uint64_t us = ms * 1000ULL > worked ? ms * 1000ULL - worked : 0;
+    const uint64_t toNextSecond = 1000000 - fake_rtc::MicrosIntoDay() % 1000000;
+    if (us > toNextSecond)
+    {
+        us = toNextSecond;
+    }
+    host_advanceMicros((uint32_t)us);
+    s_slept[state] += us;
+    return state;
+}
@@ -0,0 +1,25 @@
+#pragma once
+#include <stdint.h>
+
+#include "power_hal.hpp"
+
+// power_hal.hpp on the host: sleeping moves host time on to when the
+// processor would have woken, ms later or at the start of fake_rtc's next
+// second, and counts the time slept in each state. Nothing wakes it early.
+namespace fake_power
+{
+// counters cleared, deep sleep usable, no hook
+void Reset();
+
+// Without deep sleep, asking for it gets normal sleep, as on hardware that
+// can't keep the RTC's alarm running in deep sleep
+void SetDeepSleepUsable(bool usable);
+
+// Called at the start of every sleep, so a benchmark can move host time on
+// by what the work before it would have taken on the clock. That time
+// counts against the sleep, as the wait was worked out before the work.
+void SetBeforeSleep(void (*hook)());
+
+// us, in POWER_SLEEP or POWER_DEEP_SLEEP
+uint64_t Slept(PowerState_e state);
+} // namespace fake_power
@@ -0,0 +1,91 @@
+#include <Arduino.h>
+
+#include "fake_rtc.hpp"
+#include "rtc_hal.hpp"
+
+enum : uint64_t
+{
+    MICROS_PER_DAY = 24ULL * 3600 * 1000000,
+};
+
+// added to micros() for the time of day
+static uint64_t s_offset = 0;
+static int s_trim = 0;
+
+uint64_t fake_rtc::MicrosIntoDay()
+{
+    return (micros() + s_offset) % MICROS_PER_DAY;
+}
+
+void rtc_hal_init()
+{
+}
+
+void rtc_hal_update()
+{
+}
+
+void rtc_hal_service()
+{
+}
+
+bool rtc_hal_needsService()
+{
+    return false;
+}
+
+int rtc_hal_hour()
+{
+    return (int)(fake_rtc::MicrosIntoDay() / 3600000000ULL);
+}
+
+int rtc_hal_hourFormat12()
+{
+    const int hour = rtc_hal_hour() % 12;
+    return hour ? hour : 12;
+}
+
+int rtc_hal_minute()
+{
+    return (int)(fake_rtc::MicrosIntoDay() / 60000000 % 60);
+}
+
+int rtc_hal_second()
+{
+    return (int)(fake_rtc::MicrosIntoDay() / 1000000 % 60);
+}
+
+int rtc_hal_hundredths()
+{
+    return (int)(fake_rtc::MicrosIntoDay() / 10000 % 100);
+}
+
+int rtc_hal_millis()
+{
+    return (int)(fake_rtc::MicrosIntoDay() / 1000 % 1000);
+}
+
+void rtc_hal_setTime(int h, int m, int s)
+{
+    const uint64_t time = ((h * 60ULL + m) * 60 + s) * 1000000;
+    s_offset = (time + MICROS_PER_DAY - micros() % MICROS_PER_DAY) % MICROS_PER_DAY;
+}
+
+void rtc_hal_setDate(int, int, int)
+{
+}
+
+void rtc_hal_setTrim(int trim)
+{
+    s_trim = trim;
+}
+
+int rtc_hal_trim()
+{
+    return s_trim;
+}
+
+bool rtc_hal_trimChanged()
+{
+    return false;
+}
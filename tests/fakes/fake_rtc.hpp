@@ -0,0 +1,11 @@
+#pragma once
+#include <stdint.h>
+
+// rtc_hal.hpp on top of micros(): the time of day moves on with host time,
+// from whatever rtc_hal_setTime() set last or midnight. There's no
+// oscillator to trim and no backup clock to learn the trim from.
+namespace fake_rtc
+{
+// us since midnight
+uint64_t MicrosIntoDay();
+} // namespace fake_rtc
@@ -0,0 +1,68 @@
+#include <am_hal_gpio.h>
+#include <string.h>
+
+HostDwt host_dwt;
+HostCoreDebug host_coreDebug;
+uint32_t host_fastGpioSets = 0;
+
+enum
+{
+    // cycles high from which a bit is a 1: 600ns, between the high times
+    // for a 0 and for a 1 at both 800 and 400kHz
+    ONE_CYCLES = 600 * (AM_HAL_CLKGEN_FREQ_MAX_HZ / 1000000) / 1000,
+
+    WIRE_BYTES = 2048,
+};
+
+static bool s_high = false;
+static uint32_t s_highSince = 0;
+static uint8_t s_wire[WIRE_BYTES];
+static uint32_t s_wireBits = 0;
+
+void host_fastGpioSet()
+{
+    ++host_fastGpioSets;
+    s_high = true;
+    s_highSince = host_dwt.CYCCNT.count;
+}
+
+void host_fastGpioClr()
+{
+    if (!s_high)
+    {
+        return;
+    }
+    s_high = false;
+
+    const uint32_t byte = s_wireBits / 8;
+    if (byte < WIRE_BYTES)
+    {
+        const uint8_t bit = 0x80 >> (s_wireBits % 8);
+        const bool one = (host_dwt.CYCCNT.count - s_highSince >= ONE_CYCLES);
+        s_wire[byte] = one ? (s_wire[byte] | bit) : (s_wire[byte] & ~bit);
+    }
+    ++s_wireBits;
+}
+
+uint32_t host_takeWireBytes(uint8_t *bytes, const uint32_t max)
+{
+    const uint32_t sent = s_wireBits / 8;
+    const uint32_t kept = sent < WIRE_BYTES ? sent : WIRE_BYTES;
+    memcpy(bytes, s_wire, kept < max ? kept : max);
+    s_wireBits = 0;
+    return sent;
+}
+
+static uint32_t s_interruptsOff = 0;
+
+uint32_t am_hal_interrupt_master_disable(void)
+{
+    const uint32_t state = s_interruptsOff;
+    s_interruptsOff = 1;
+    return state;
+}
+
+void am_hal_interrupt_master_set(uint32_t state)
+{
+    s_interruptsOff = state;
+}
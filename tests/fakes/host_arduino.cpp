@@ -0,0 +1,78 @@
+#include <Arduino.h>
+#include <EEPROM.h>
+#include <Wire.h>
+
+static uint64_t s_micros = 0;
+
+unsigned long micros()
+{
+    return (unsigned long)s_micros;
+}
+
+unsigned long millis()
+{
+    return (unsigned long)(s_micros / 1000);
+}
+
+void delay(unsigned long ms)
+{
+    s_micros += ms * 1000ULL;
+}
+
+void host_advanceMicros(uint32_t us)
+{
+    s_micros += us;
+}
+
+// pins read HIGH until a test sets them, like the buttons' pull-ups
+enum
+{
+    HOST_PINS = 64,
+};
+static int s_pinLevels[HOST_PINS];
+static void (*s_pinIsrs[HOST_PINS])(void);
+
+int digitalRead(int pin)
+{
+    return s_pinLevels[pin] ? LOW : HIGH;
+}
+
+void host_setPin(int pin, int level)
+{
+    const bool changed = (digitalRead(pin) != level);
+    s_pinLevels[pin] = (level == LOW);
+    if (changed && s_pinIsrs[pin])
+    {
+        s_pinIsrs[pin]();
+    }
+}
+
+void digitalWrite(int, int)
+{
+}
+
+void pinMode(int, int)
+{
+}
+
+void attachInterrupt(int interrupt, void (*isr)(void), int)
+{
+    s_pinIsrs[interrupt] = isr;
+}
+
+void detachInterrupt(int interrupt)
+{
+    s_pinIsrs[interrupt] = nullptr;
+}
+
+void noInterrupts()
+{
+}
+
+void interrupts()
+{
+}
+
+HostSerial Serial;
+HostEEPROM EEPROM;
+TwoWire Wire;
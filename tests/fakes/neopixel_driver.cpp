@@ -0,0 +1,4 @@
+// Adafruit_NeoPixel.cpp only picks its Apollo3 code on an ARM compiler
+#include <Arduino.h>
+#define __arm__
+#include "Adafruit_NeoPixel.cpp"
@@ -0,0 +1,22 @@
+#pragma once
+// The hardware configuration from firmware.ino, which the firmware headers
+// expect to be defined before they're included
+#include <Arduino.h>
+
+enum HardwareConfig_e
+{
+    PIN_FOR_LEDS = 2,
+    NUM_LEDS = 122,
+    NUM_DIGITS = 6,
+    NUM_BTNS = 4,
+
+    DELAY_FOR_COMBINATION_BUTTONS = 750,
+};
+
+enum Pins_e
+{
+    PIN_BTN_H = 3,
+    PIN_BTN_M = 4,
+    PIN_BTN_C = 5,
+    PIN_BTN_B = 6,
+};
@@ -0,0 +1,65 @@
+#pragma once
+// Just enough of the Arduino API for the firmware headers to build on the
+// host. Time only moves when a test moves it, see host_arduino.cpp.
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(AM_PART_APOLLO3)
+#include <am_mcu_apollo.h>
+#include <ap3_types.h>
+#endif
+
+typedef bool boolean;
+#define PROGMEM
+#define pgm_read_byte(p) (*(const uint8_t *)(p))
+
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+#define CHANGE 3
+#define LOW 0
+#define HIGH 1
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+int digitalRead(int pin);
+void digitalWrite(int pin, int value);
+void pinMode(int pin, int mode);
+void attachInterrupt(int interrupt, void (*isr)(void), int mode);
+void detachInterrupt(int interrupt);
+inline int digitalPinToInterrupt(int pin)
+{
+    return pin;
+}
+void noInterrupts();
+void interrupts();
+
+struct HostSerial
+{
+    void begin(int)
+    {
+    }
+    template <typename T> void print(T)
+    {
+    }
+    template <typename T> void println(T)
+    {
+    }
+    void println()
+    {
+    }
+    void flush()
+    {
+    }
+};
+extern HostSerial Serial;
+
+// for tests: moves micros() and millis() on
+void host_advanceMicros(uint32_t us);
+// for tests: sets what digitalRead() returns for the pin, and runs its
+// interrupt handler if the level changed
+void host_setPin(int pin, int level);
@@ -0,0 +1,20 @@
+#pragma once
+#include <Arduino.h>
+
+// emulated EEPROM, never written unless a test fills in bytes
+struct HostEEPROM
+{
+    uint8_t bytes[1024];
+
+    HostEEPROM()
+    {
+        memset(bytes, 0xFF, sizeof(bytes));
+    }
+
+    template <typename T> T &get(int address, T &value)
+    {
+        memcpy(&value, bytes + address, sizeof(value));
+        return value;
+    }
+};
+extern HostEEPROM EEPROM;
@@ -0,0 +1,103 @@
+#pragma once
+#include <Arduino.h>
+
+// A device on the host's I2C bus, see TwoWire::Attach()
+class I2CDevice
+{
+  public:
+    virtual ~I2CDevice()
+    {
+    }
+
+    // a write transaction, false to NACK it
+    virtual bool Write(const uint8_t *data, uint8_t count) = 0;
+
+    // the next byte of a read transaction
+    virtual uint8_t Read() = 0;
+};
+
+// Wire with one device attached at a time. Transactions addressed to
+// anything else are NACKed.
+class TwoWire
+{
+  private:
+    enum
+    {
+        BUFFER_SIZE = 32, // as in the Arduino cores
+    };
+
+    I2CDevice *m_device{nullptr};
+    uint8_t m_address{0};
+    uint8_t m_deviceAddress{0};
+    uint8_t m_buffer[BUFFER_SIZE];
+    uint8_t m_count{0};
+    uint8_t m_available{0};
+
+  public:
+    uint32_t transactions{0};
+
+    void Attach(I2CDevice *device, uint8_t address)
+    {
+        m_device = device;
+        m_deviceAddress = address;
+    }
+
+    void begin()
+    {
+    }
+
+    void setClock(uint32_t)
+    {
+    }
+
+    void beginTransmission(uint8_t address)
+    {
+        m_address = address;
+        m_count = 0;
+    }
+
+    size_t write(uint8_t value)
+    {
+        if (m_count == BUFFER_SIZE)
+        {
+            return 0;
+        }
+        m_buffer[m_count++] = value;
+        return 1;
+    }
+
+    // 0 on success, 2 for a NACK on the address, as in the Arduino cores
+    uint8_t endTransmission(bool stop = true)
+    {
+        ++transactions;
+        if (!m_device || m_address != m_deviceAddress || !m_device->Write(m_buffer, m_count))
+        {
+            return 2;
+        }
+        return 0;
+    }
+
+    uint8_t requestFrom(uint8_t address, uint8_t count)
+    {
+        ++transactions;
+        m_available = (m_device && address == m_deviceAddress) ? count : 0;
+        return m_available;
+    }
+
+    int available()
+    {
+        return m_available;
+    }
+
+    int read()
+    {
+        if (!m_available)
+        {
+            return -1;
+        }
+        --m_available;
+        return m_device->Read();
+    }
+};
+
+extern TwoWire Wire;
@@ -0,0 +1,22 @@
+#pragma once
+#include <am_mcu_apollo.h>
+
+// Fast GPIO that counts the rising edges, one per bit sent, and reads each
+// bit back from how long the pin stayed high, see host_takeWireBytes()
+extern uint32_t host_fastGpioSets;
+void host_fastGpioSet();
+void host_fastGpioClr();
+
+// Copies out up to max of the bytes sent since the last call, and forgets
+// them all. Returns how many were sent.
+uint32_t host_takeWireBytes(uint8_t *bytes, uint32_t max);
+
+#define am_hal_gpio_fastgpio_set(pad) host_fastGpioSet()
+#define am_hal_gpio_fastgpio_clr(pad) host_fastGpioClr()
+#define am_hal_gpio_fastgpio_disable(pad) ((void)0)
+#define am_hal_gpio_fast_pinconfig(mask, config, flags) ((void)0)
+#define g_AM_HAL_GPIO_OUTPUT 0
+
+// apollo3.cpp's delays move the cycle counter on by as many cycles as they
+// take on the clock, so the time the pin is high can be measured
+#define NEO_DELAY(cycles) (host_dwt.CYCCNT.count += (cycles))
@@ -0,0 +1,38 @@
+#pragma once
+// The parts of the Apollo3 HAL and CMSIS the firmware uses, see
+// host_apollo3.cpp
+#include <stdint.h>
+
+#define AM_HAL_CLKGEN_FREQ_MAX_HZ 48000000
+
+// The cycle counter moves on by one every time it's read, which is enough
+// for the loops that wait on it to finish
+struct HostCycleCounter
+{
+    uint32_t count;
+    operator uint32_t()
+    {
+        return count++;
+    }
+};
+
+struct HostDwt
+{
+    HostCycleCounter CYCCNT;
+    uint32_t CTRL;
+};
+
+struct HostCoreDebug
+{
+    uint32_t DEMCR;
+};
+
+extern HostDwt host_dwt;
+extern HostCoreDebug host_coreDebug;
+#define DWT (&host_dwt)
+#define CoreDebug (&host_coreDebug)
+#define CoreDebug_DEMCR_TRCENA_Msk (1UL << 24)
+#define DWT_CTRL_CYCCNTENA_Msk 1UL
+
+uint32_t am_hal_interrupt_master_disable(void);
+void am_hal_interrupt_master_set(uint32_t state);
@@ -0,0 +1,5 @@
+#pragma once
+#include <stdint.h>
+
+typedef uint32_t ap3_gpio_pad_t;
+#define ap3_gpio_pin2pad(pin) ((ap3_gpio_pad_t)(pin))
@@ -0,0 +1,78 @@
+// The SIMD color kernels give bit-for-bit what the plain C ones do, for
+// every value each channel can take. The channels of a color are worked on
+// independently, so every pair of channel values goes through each channel
+// at once, with the top byte set to something other than zero to show it
+// never leaks into the result.
+#include "check.hpp"
+#include "color_kernels.hpp"
+#include "color_kernels_dsp.hpp"
+
+#ifdef FOXIE_DSP_COLOR
+#error The plain C versions should be built here
+#endif
+
+// x and y in each of the three channels, mixed up so that no two channels
+// see the same pair at the same time
+static uint32_t Pack(const uint32_t top, const uint32_t x, const uint32_t y)
+{
+    return (top << 24) | (x << 16) | ((y ^ 0x5A) << 8) | (255 - x);
+}
+
+static void TestScale()
+{
+    uint32_t mismatches = 0;
+    for (uint32_t x = 0; x < 256; ++x)
+    {
+        for (uint32_t brightness = 0; brightness < 256; ++brightness)
+        {
+            const uint32_t color = Pack(x ^ brightness, x, x ^ 0xA5);
+            mismatches += ColorScale(color, brightness) != DspColorScale(color, brightness);
+        }
+    }
+    CHECK(mismatches == 0);
+}
+
+static void TestLerp()
+{
+    uint32_t mismatches = 0;
+    for (uint32_t x = 0; x < 256; ++x)
+    {
+        for (uint32_t y = 0; y < 256; ++y)
+        {
+            const uint32_t a = Pack(x, x, y);
+            const uint32_t b = Pack(~y & 0xFF, y, x);
+            for (uint32_t t = 0; t < 256; ++t)
+            {
+                mismatches += ColorLerp(a, b, t) != DspColorLerp(a, b, t);
+            }
+        }
+    }
+    CHECK(mismatches == 0);
+}
+
+static void TestPairwise()
+{
+    uint32_t mismatches[3] = {0};
+    for (uint32_t x = 0; x < 256; ++x)
+    {
+        for (uint32_t y = 0; y < 256; ++y)
+        {
+            const uint32_t a = Pack(x ^ y, x, y);
+            const uint32_t b = Pack(x + y, y, x);
+            mismatches[0] += ColorAddSaturate(a, b) != DspColorAddSaturate(a, b);
+            mismatches[1] += ColorAverage(a, b) != DspColorAverage(a, b);
+            mismatches[2] += ColorMax(a, b) != DspColorMax(a, b);
+        }
+    }
+    CHECK(mismatches[0] == 0);
+    CHECK(mismatches[1] == 0);
+    CHECK(mismatches[2] == 0);
+}
+
+int main()
+{
+    TestScale();
+    TestLerp();
+    TestPairwise();
+    return TestResult();
+}
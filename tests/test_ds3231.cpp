@@ -0,0 +1,255 @@
+// The DS3231 driver against a model of the chip's registers
+#include <Arduino.h>
+
+#include "check.hpp"
+#include "ds3231.hpp"
+
+// The DS3231's 19 registers. A write sets the register pointer and then
+// stores into the registers from there, and a read carries on from the
+// pointer, wrapping around after the last one.
+class FakeDS3231 : public I2CDevice
+{
+  public:
+    enum
+    {
+        REGISTERS = 0x13,
+    };
+
+    uint8_t regs[REGISTERS] = {0};
+    uint8_t pointer{0};
+
+    // the next few reads get their registers from bad instead
+    int badReads{0};
+    uint8_t bad[DS3231::TIME_REGISTERS] = {0};
+    int nextBad{-1};
+
+    virtual bool Write(const uint8_t *data, uint8_t count) override
+    {
+        if (count == 0)
+        {
+            return true;
+        }
+        pointer = data[0] % REGISTERS;
+        for (uint8_t i = 1; i < count; ++i)
+        {
+            regs[pointer] = data[i];
+            pointer = (pointer + 1) % REGISTERS;
+        }
+        if (badReads > 0 && pointer == 0)
+        {
+            --badReads;
+            nextBad = 0;
+        }
+        return true;
+    }
+
+    virtual uint8_t Read() override
+    {
+        if (nextBad >= 0 && nextBad < DS3231::TIME_REGISTERS)
+        {
+            pointer = (pointer + 1) % REGISTERS;
+            return bad[nextBad++];
+        }
+        const uint8_t value = regs[pointer];
+        pointer = (pointer + 1) % REGISTERS;
+        return value;
+    }
+
+    void Set(const uint8_t second, const uint8_t minute, const uint8_t hour, const uint8_t day, const uint8_t date,
+             const uint8_t month, const uint8_t year)
+    {
+        const uint8_t values[] = {second, minute, hour, day, date, month, year};
+        memcpy(regs, values, sizeof(values));
+    }
+};
+
+static FakeDS3231 s_chip;
+
+static void Attach()
+{
+    s_chip = FakeDS3231();
+    Wire.Attach(&s_chip, DS3231::I2C_ADDRESS);
+    Wire.transactions = 0;
+}
+
+static bool ReadTime(DS3231::DateTime &dt)
+{
+    DS3231 clock(Wire);
+    return clock.Read(dt);
+}
+
+static bool Same(const DS3231::DateTime &a, const DS3231::DateTime &b)
+{
+    return a.second == b.second && a.minute == b.minute && a.hour == b.hour && a.dayOfWeek == b.dayOfWeek &&
+           a.dayOfMonth == b.dayOfMonth && a.month == b.month && a.year == b.year;
+}
+
+// One transaction writes all seven registers as BCD, in 24H mode
+static void TestBurstWrite()
+{
+    Attach();
+    DS3231 clock(Wire);
+    DS3231::DateTime dt;
+    dt.second = 59;
+    dt.minute = 42;
+    dt.hour = 23;
+    dt.dayOfWeek = 7;
+    dt.dayOfMonth = 31;
+    dt.month = 12;
+    dt.year = 99;
+    CHECK(clock.Write(dt));
+    CHECK(Wire.transactions == 1);
+
+    const uint8_t expected[] = {0x59, 0x42, 0x23, 0x07, 0x31, 0x12, 0x99};
+    CHECK(memcmp(s_chip.regs, expected, sizeof(expected)) == 0);
+    CHECK(s_chip.regs[7] == 0); // the alarm registers after them are untouched
+}
+
+// Whatever the time, it reads back as it was written, in one write to set
+// the pointer and one read of the seven registers
+static void TestRoundTrip()
+{
+    Attach();
+    DS3231 clock(Wire);
+    uint32_t mismatches = 0;
+    for (uint8_t hour = 0; hour < 24; ++hour)
+    {
+        for (uint8_t minute = 0; minute < 60; ++minute)
+        {
+            DS3231::DateTime dt;
+            dt.second = (minute * 7 + hour) % 60;
+            dt.minute = minute;
+            dt.hour = hour;
+            dt.dayOfWeek = 1 + (minute % 7);
+            dt.dayOfMonth = 1 + (minute % 31);
+            dt.month = 1 + (hour % 12);
+            dt.year = (hour * 60 + minute) % 100;
+            CHECK(clock.Write(dt));
+
+            Wire.transactions = 0;
+            DS3231::DateTime read;
+            CHECK(clock.Read(read));
+            CHECK(Wire.transactions == 2);
+            mismatches += !Same(dt, read);
+        }
+    }
+    CHECK(mismatches == 0);
+}
+
+// Every value of the seconds register: BCD up to 59 decodes, the CH bit
+// is ignored, and anything else fails the read
+static void TestBCD()
+{
+    uint32_t wrong = 0;
+    for (uint32_t reg = 0; reg < 256; ++reg)
+    {
+        Attach();
+        s_chip.Set(reg, 0x00, 0x00, 0x01, 0x01, 0x01, 0x00);
+        DS3231::DateTime dt;
+        const bool ok = ReadTime(dt);
+
+        const uint8_t tens = (reg & 0x7F) >> 4;
+        const uint8_t ones = reg & 0x0F;
+        const bool valid = ones <= 9 && tens * 10 + ones < 60;
+        wrong += ok != valid || (ok && dt.second != tens * 10 + ones);
+    }
+    CHECK(wrong == 0);
+
+    // the year uses all eight bits
+    Attach();
+    s_chip.Set(0x00, 0x00, 0x00, 0x01, 0x01, 0x01, 0x9A);
+    DS3231::DateTime dt;
+    CHECK(!ReadTime(dt));
+}
+
+// In 12H mode bit 6 of the hours is set and bit 5 is PM
+static void TestTwelveHour()
+{
+    for (uint8_t hour12 = 0; hour12 <= 19; ++hour12)
+    {
+        for (int pm = 0; pm < 2; ++pm)
+        {
+            Attach();
+            const uint8_t bcd = ((hour12 / 10) << 4) | (hour12 % 10);
+            s_chip.Set(0x00, 0x00, 0x40 | (pm ? 0x20 : 0) | bcd, 0x01, 0x01, 0x01, 0x00);
+            DS3231::DateTime dt;
+            const bool ok = ReadTime(dt);
+            if (hour12 < 1 || hour12 > 12)
+            {
+                CHECK(!ok);
+                continue;
+            }
+            CHECK(ok);
+            CHECK(dt.hour == (hour12 % 12) + (pm ? 12 : 0));
+        }
+    }
+
+    // 24H mode uses bit 5 for the tens of 20 to 23
+    Attach();
+    s_chip.Set(0x00, 0x00, 0x23, 0x01, 0x01, 0x01, 0x00);
+    DS3231::DateTime dt;
+    CHECK(ReadTime(dt) && dt.hour == 23);
+    s_chip.Set(0x00, 0x00, 0x24, 0x01, 0x01, 0x01, 0x00);
+    CHECK(!ReadTime(dt));
+}
+
+// The century flag in bit 7 of the month register doesn't change the month
+// or the two-digit year, and Write() leaves it clear
+static void TestCentury()
+{
+    for (uint8_t month = 1; month <= 12; ++month)
+    {
+        Attach();
+        const uint8_t bcd = ((month / 10) << 4) | (month % 10);
+        s_chip.Set(0x00, 0x00, 0x00, 0x01, 0x01, 0x80 | bcd, 0x00);
+        DS3231::DateTime dt;
+        CHECK(ReadTime(dt));
+        CHECK(dt.month == month);
+        CHECK(dt.year == 0);
+    }
+
+    Attach();
+    DS3231 clock(Wire);
+    DS3231::DateTime dt;
+    dt.month = 12;
+    CHECK(clock.Write(dt));
+    CHECK((s_chip.regs[5] & 0x80) == 0);
+}
+
+// A transfer that comes back damaged is read again, up to
+// MAX_READ_ATTEMPTS times, and a failed read leaves the time alone
+static void TestRetries()
+{
+    const uint8_t bad[DS3231::TIME_REGISTERS] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+    for (int badReads = 0; badReads <= DS3231::MAX_READ_ATTEMPTS; ++badReads)
+    {
+        Attach();
+        s_chip.Set(0x30, 0x15, 0x12, 0x03, 0x14, 0x07, 0x26);
+        s_chip.badReads = badReads;
+        memcpy(s_chip.bad, bad, sizeof(bad));
+
+        DS3231::DateTime dt;
+        dt.minute = 1;
+        const bool ok = ReadTime(dt);
+        CHECK(ok == (badReads < DS3231::MAX_READ_ATTEMPTS));
+        CHECK(dt.minute == (ok ? 15 : 1));
+    }
+
+    // no chip at all
+    Wire.Attach(nullptr, 0);
+    DS3231 clock(Wire);
+    DS3231::DateTime dt;
+    CHECK(!clock.Read(dt));
+    CHECK(!clock.Write(dt));
+}
+
+int main()
+{
+    TestBurstWrite();
+    TestRoundTrip();
+    TestBCD();
+    TestTwelveHour();
+    TestCentury();
+    TestRetries();
+    return TestResult();
+}
@@ -0,0 +1,24 @@
+// EaseSine, which unlike the other curves comes from a table that's only
+// read at run time. The rest are checked by static_asserts in easing.hpp.
+#include <Arduino.h>
+
+#include "check.hpp"
+#include "easing.hpp"
+
+int main()
+{
+    CHECK(Ease<EaseSine>(0) == 0);
+    CHECK(Ease<EaseSine>(255) >= 254); // the table's peak is a step past 255
+    for (int phase = 0; phase < 255; ++phase)
+    {
+        CHECK(Ease<EaseSine>(phase) <= Ease<EaseSine>(phase + 1));
+    }
+
+    // and the tables hold what the curves say
+    for (int phase = 0; phase < 256; ++phase)
+    {
+        CHECK(Ease<EaseInOutCubic>(phase) == EaseInOutCubic::At(phase));
+        CHECK(Ease<EaseOutBounce>(phase) == EaseOutBounce::At(phase));
+    }
+    return TestResult();
+}
@@ -0,0 +1,153 @@
+// The settings journal on flash that loses power part way through writes
+// and erases. Whatever point a commit is cut off at, the next boot has to
+// load either the record from before it or the one it was writing, and
+// carry on committing from there.
+#include <Arduino.h>
+
+#include "check.hpp"
+#include "fake_flash.hpp"
+#include "settings_journal.hpp"
+
+// laid out like SettingsRecord
+struct Record
+{
+    uint8_t version;
+    uint8_t count;
+    uint16_t values[11];
+
+    bool operator==(const Record &other) const
+    {
+        return memcmp(this, &other, sizeof(*this)) == 0;
+    }
+};
+
+static uint32_t s_random = 12345;
+
+static uint32_t Random()
+{
+    s_random = s_random * 1103515245 + 12345;
+    return s_random >> 8;
+}
+
+static void Change(Record &record)
+{
+    record.version = 2;
+    record.count = 11;
+    record.values[Random() % 11] = Random();
+}
+
+static bool Boot(Record &loaded)
+{
+    SettingsJournal journal(&loaded, sizeof(loaded));
+    return journal.Load(&loaded);
+}
+
+// Erases are spread evenly over the pages, and only happen once a page is
+// full
+static void TestWearLeveling()
+{
+    fake_flash::Reset();
+    Record record{};
+    SettingsJournal journal(&record, sizeof(record));
+
+    enum
+    {
+        COMMITS = 5000,
+        RECORD_WORDS = 1 + sizeof(Record) / sizeof(uint32_t),
+        PER_PAGE = (fake_flash::WORDS_PER_PAGE - 2) / RECORD_WORDS,
+    };
+    for (int i = 0; i < COMMITS; ++i)
+    {
+        Change(record);
+        while (journal.Step())
+        {
+        }
+    }
+
+    uint32_t least = ~0u, most = 0, total = 0;
+    for (int page = 0; page < fake_flash::PAGES; ++page)
+    {
+        const uint32_t erases = fake_flash::EraseCount(page);
+        least = erases < least ? erases : least;
+        most = erases > most ? erases : most;
+        total += erases;
+    }
+    CHECK(most - least <= 1);
+    CHECK(total <= COMMITS / PER_PAGE + 1);
+
+    Record loaded;
+    CHECK(Boot(loaded));
+    CHECK(loaded == record);
+}
+
+// Each commit is cut off after a few words, including ones that compact,
+// and then the clock boots again from what's in flash. The check word's
+// 16-bit CRC lets through about one torn copy in 65536, so far more trials
+// than these will eventually load a damaged record; these don't.
+static void TestPowerCuts()
+{
+    enum
+    {
+        TRIALS = 20000,
+        LONGEST_COMMIT = 12, // an erase, a copy of the record and the header, and then some
+    };
+
+    fake_flash::Reset();
+    Record committed{};
+    Change(committed);
+    {
+        SettingsJournal journal(&committed, sizeof(committed));
+        while (journal.Step())
+        {
+        }
+    }
+
+    uint32_t cuts = 0;
+    uint32_t lost = 0;
+    for (uint32_t trial = 0; trial < TRIALS; ++trial)
+    {
+        Record record;
+        SettingsJournal journal(&record, sizeof(record));
+        if (!journal.Load(&record))
+        {
+            CHECK(!"nothing loaded");
+            return;
+        }
+        CHECK(record == committed);
+
+        Change(record);
+        if (trial % 5 == 0)
+        {
+            journal.Compact();
+        }
+
+        fake_flash::CutPowerAfter(1 + trial % LONGEST_COMMIT, trial);
+        while (journal.Step())
+        {
+        }
+        const bool wasCut = fake_flash::PowerWasCut();
+        fake_flash::RestorePower();
+
+        Record loaded;
+        CHECK(Boot(loaded));
+        CHECK(loaded == committed || loaded == record);
+        if (!wasCut)
+        {
+            CHECK(loaded == record);
+        }
+        cuts += wasCut;
+        lost += wasCut && loaded == committed;
+        committed = loaded;
+    }
+
+    // most trials are cut off, and the cut loses the new record in some
+    CHECK(cuts > TRIALS / 2);
+    CHECK(lost > 0);
+}
+
+int main()
+{
+    TestWearLeveling();
+    TestPowerCuts();
+    return TestResult();
+}
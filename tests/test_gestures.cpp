@@ -0,0 +1,319 @@
+// Gestures from scripted button edges: the pin interrupts feed ButtonInput,
+// a loop runs every ms as on the clock, and GestureEngine has to dispatch
+// exactly the expected actions at exactly the expected times
+#include "host_config.hpp"
+#include <initializer_list>
+#include <vector>
+
+#include "button_input.hpp"
+#include "check.hpp"
+#include "gestures.hpp"
+
+enum
+{
+    STATE_NORMAL = 1,
+    STATE_SET = 2,
+};
+
+enum Action_e
+{
+    ACTION_TAP_H,
+    ACTION_HOLD_H,
+    ACTION_PRESS_H_SET,
+    ACTION_PRESS_M,
+    ACTION_REPEAT_M,
+    ACTION_RELEASE_M,
+    ACTION_TAP_C,
+    ACTION_DOUBLE_TAP_C,
+    ACTION_HOLD_HM,
+};
+
+static const GestureBinding BINDINGS[] = {
+    {STATE_NORMAL, BTN_BIT_H, GESTURE_TAP, 0, ACTION_TAP_H},
+    {STATE_NORMAL, BTN_BIT_H, GESTURE_HOLD, DELAY_FOR_COMBINATION_BUTTONS, ACTION_HOLD_H},
+    {STATE_SET, BTN_BIT_H, GESTURE_PRESS, 0, ACTION_PRESS_H_SET},
+    {STATE_NORMAL, BTN_BIT_M, GESTURE_PRESS, 0, ACTION_PRESS_M},
+    {STATE_NORMAL, BTN_BIT_M, GESTURE_REPEAT, 100, ACTION_REPEAT_M},
+    {STATE_NORMAL, BTN_BIT_M, GESTURE_RELEASE, 0, ACTION_RELEASE_M},
+    {STATE_NORMAL, BTN_BIT_C, GESTURE_TAP, 0, ACTION_TAP_C},
+    {STATE_NORMAL, BTN_BIT_C, GESTURE_DOUBLE_TAP, 0, ACTION_DOUBLE_TAP_C},
+    {STATE_NORMAL, BTN_BIT_H | BTN_BIT_M, GESTURE_HOLD, DELAY_FOR_COMBINATION_BUTTONS, ACTION_HOLD_HM},
+};
+
+struct Fired
+{
+    uint8_t action;
+    uint32_t ms; // since the rig was made
+
+    bool operator==(const Fired &other) const
+    {
+        return action == other.action && ms == other.ms;
+    }
+};
+
+// Clock::CheckForButtonEvents() cut down to the buttons, with the actions
+// recorded instead of done
+class ButtonRig
+{
+  public:
+    ButtonInput buttons;
+    GestureEngine gestures;
+    uint8_t state{STATE_NORMAL};
+    std::vector<Fired> fired;
+
+  private:
+    const uint32_t m_start{(uint32_t)millis()};
+
+  public:
+    ButtonRig()
+    {
+        gestures.SetBindings(BINDINGS);
+        gestures.handler = GestureEngine::Bind<ButtonRig, &ButtonRig::HandleButtonAction>(*this);
+    }
+
+    // runs a loop at every ms up to this many after the rig was made, so an
+    // edge scripted after it lands just before the loop at that ms
+    void RunUntil(const uint32_t ms)
+    {
+        while (millis() - m_start < ms)
+        {
+            bool hadEdges = false;
+            const uint8_t pressedMask = buttons.Sample(hadEdges);
+            gestures.Update(pressedMask, state, millis());
+            host_advanceMicros(1000);
+        }
+    }
+
+    bool FiredExactly(const std::initializer_list<Fired> expected) const
+    {
+        if (fired == std::vector<Fired>(expected))
+        {
+            return true;
+        }
+        printf("fired:");
+        for (const Fired &f : fired)
+        {
+            printf(" %d@%u", f.action, (unsigned)f.ms);
+        }
+        printf("\n");
+        return false;
+    }
+
+  private:
+    void HandleButtonAction(const uint8_t action)
+    {
+        fired.push_back({action, (uint32_t)(millis() - m_start)});
+    }
+};
+
+static void Press(const Pins_e pin)
+{
+    host_setPin(pin, LOW);
+}
+
+static void Release(const Pins_e pin)
+{
+    host_setPin(pin, HIGH);
+}
+
+// edges that don't last DEBOUNCE_TIME are ignored, and a change counts from
+// the last edge of its bounce
+static void TestDebounce()
+{
+    ButtonRig rig;
+
+    // a 10ms glitch
+    Press(PIN_BTN_H);
+    rig.RunUntil(10);
+    Release(PIN_BTN_H);
+    rig.RunUntil(100);
+    CHECK(rig.FiredExactly({}));
+
+    // a bouncing press, a glitch while held and a bouncing release: one tap,
+    // DEBOUNCE_TIME after the last bounce
+    rig.fired.clear();
+    Press(PIN_BTN_H);
+    rig.RunUntil(105);
+    Release(PIN_BTN_H);
+    rig.RunUntil(108);
+    Press(PIN_BTN_H);
+    rig.RunUntil(300);
+    Release(PIN_BTN_H);
+    rig.RunUntil(310);
+    Press(PIN_BTN_H);
+    rig.RunUntil(500);
+    Release(PIN_BTN_H);
+    rig.RunUntil(503);
+    Press(PIN_BTN_H);
+    rig.RunUntil(506);
+    Release(PIN_BTN_H);
+    rig.RunUntil(1000);
+    CHECK(rig.FiredExactly({{ACTION_TAP_H, 506 + GestureEngine::DEBOUNCE_TIME}}));
+}
+
+// a HOLD fires DELAY_FOR_COMBINATION_BUTTONS after the debounced press and
+// stops the TAP; released before then, it's a TAP
+static void TestTapOrHold()
+{
+    {
+        ButtonRig rig;
+        Press(PIN_BTN_H);
+        rig.RunUntil(DELAY_FOR_COMBINATION_BUTTONS);
+        Release(PIN_BTN_H);
+        rig.RunUntil(2000);
+        CHECK(rig.FiredExactly({{ACTION_TAP_H, 770}}));
+    }
+    {
+        // still held, debounced, when the hold time comes
+        ButtonRig rig;
+        Press(PIN_BTN_H);
+        rig.RunUntil(DELAY_FOR_COMBINATION_BUTTONS + 1);
+        Release(PIN_BTN_H);
+        rig.RunUntil(2000);
+        CHECK(rig.FiredExactly({{ACTION_HOLD_H, 770}}));
+    }
+    {
+        // the state the clock is in picks the bindings
+        ButtonRig rig;
+        rig.state = STATE_SET;
+        Press(PIN_BTN_H);
+        rig.RunUntil(100);
+        Release(PIN_BTN_H);
+        rig.RunUntil(200);
+        CHECK(rig.FiredExactly({{ACTION_PRESS_H_SET, 20}}));
+    }
+}
+
+// the first REPEAT comes REPEAT_DELAY after the press, then one every
+// binding's timeMs, and RELEASE still fires after them
+static void TestRepeat()
+{
+    ButtonRig rig;
+    Press(PIN_BTN_M);
+    rig.RunUntil(650);
+    Release(PIN_BTN_M);
+    rig.RunUntil(1000);
+    CHECK(rig.FiredExactly({
+        {ACTION_PRESS_M, 20},
+        {ACTION_REPEAT_M, 20 + GestureEngine::REPEAT_DELAY},
+        {ACTION_REPEAT_M, 520},
+        {ACTION_REPEAT_M, 620},
+        {ACTION_RELEASE_M, 670},
+    }));
+}
+
+static void Tap(ButtonRig &rig, const Pins_e pin, const uint32_t press, const uint32_t release)
+{
+    rig.RunUntil(press);
+    Press(pin);
+    rig.RunUntil(release);
+    Release(pin);
+}
+
+// a second TAP up to DOUBLE_TAP_TIME after the first is also a DOUBLE_TAP,
+// which starts over
+static void TestDoubleTap()
+{
+    ButtonRig rig;
+    Tap(rig, PIN_BTN_C, 0, 50);
+    Tap(rig, PIN_BTN_C, 200, 350); // 300ms after the first tap
+    Tap(rig, PIN_BTN_C, 400, 450);
+    Tap(rig, PIN_BTN_C, 1000, 1050);
+    Tap(rig, PIN_BTN_C, 1300, 1351); // 301ms after
+    rig.RunUntil(2000);
+    CHECK(rig.FiredExactly({
+        {ACTION_TAP_C, 70},
+        {ACTION_TAP_C, 370},
+        {ACTION_DOUBLE_TAP_C, 370},
+        {ACTION_TAP_C, 470},
+        {ACTION_TAP_C, 1070},
+        {ACTION_TAP_C, 1371},
+    }));
+}
+
+// pressing another button turns the gesture into a combination, which
+// starts its own timing and takes over from the single button
+static void TestCombination()
+{
+    {
+        ButtonRig rig;
+        Press(PIN_BTN_H);
+        rig.RunUntil(700);
+        Press(PIN_BTN_M);
+        rig.RunUntil(2000);
+        Release(PIN_BTN_H);
+        Release(PIN_BTN_M);
+        rig.RunUntil(2500);
+        CHECK(rig.FiredExactly({{ACTION_HOLD_HM, 720 + DELAY_FOR_COMBINATION_BUTTONS}}));
+    }
+    {
+        // pressed together, within the debounce
+        ButtonRig rig;
+        Press(PIN_BTN_M);
+        rig.RunUntil(5);
+        Press(PIN_BTN_H);
+        rig.RunUntil(1000);
+        Release(PIN_BTN_H);
+        Release(PIN_BTN_M);
+        rig.RunUntil(1500);
+        CHECK(rig.FiredExactly({{ACTION_HOLD_HM, 25 + DELAY_FOR_COMBINATION_BUTTONS}}));
+    }
+}
+
+// releasing some of a combination ends it: nothing fires, not even for
+// the button still held, until every button has been released
+static void TestPartialRelease()
+{
+    ButtonRig rig;
+    Press(PIN_BTN_H);
+    Press(PIN_BTN_M);
+    rig.RunUntil(300);
+    Release(PIN_BTN_M);
+    rig.RunUntil(2000);
+    Release(PIN_BTN_H);
+    Tap(rig, PIN_BTN_H, 2100, 2200);
+    rig.RunUntil(2500);
+    CHECK(rig.FiredExactly({{ACTION_TAP_H, 2220}}));
+}
+
+// more edges than the queue holds: the pins are read instead, so the pressed
+// mask is still right, and the batch still starts at the first edge
+static void TestQueueOverflow()
+{
+    ButtonInput buttons;
+    bool hadEdges = false;
+    CHECK(buttons.Sample(hadEdges) == 0);
+    CHECK(!hadEdges);
+
+    const uint32_t first = micros();
+    for (int i = 0; i < 41; ++i)
+    {
+        host_setPin(PIN_BTN_C, i % 2 ? HIGH : LOW);
+        host_advanceMicros(100);
+    }
+    CHECK(buttons.HasEdges());
+    CHECK(buttons.Sample(hadEdges) == BTN_BIT_C);
+    CHECK(hadEdges);
+    CHECK(buttons.FirstEdgeTime() == first);
+    CHECK(!buttons.HasEdges());
+
+    // nothing new since
+    CHECK(buttons.Sample(hadEdges) == BTN_BIT_C);
+    CHECK(!hadEdges);
+
+    Release(PIN_BTN_C);
+    CHECK(buttons.Sample(hadEdges) == 0);
+    CHECK(hadEdges);
+}
+
+int main()
+{
+    TestDebounce();
+    TestTapOrHold();
+    TestRepeat();
+    TestDoubleTap();
+    TestCombination();
+    TestPartialRelease();
+    TestQueueOverflow();
+    return TestResult();
+}
@@ -0,0 +1,169 @@
+// Press-to-photon latency through the clock's button path: edges from the
+// pin interrupts, ButtonInput, GestureEngine, and the stages LatencyTrace
+// buckets, with scripted edge times
+#define FOXIE_LATENCY_TRACE
+#include "host_config.hpp"
+
+#include "button_input.hpp"
+#include "check.hpp"
+#include "gestures.hpp"
+#include "latency_trace.hpp"
+
+enum
+{
+    ACTION_B_PRESS,
+    ACTION_C_REPEAT,
+
+    // time each part of a loop takes, in us
+    MODEL_US = 100,
+    RENDER_US = 300,
+    TRANSMIT_US = 500,
+    IDLE_US = 1000, // between loops
+};
+
+static const GestureBinding BINDINGS[] = {
+    {1, BTN_BIT_B, GESTURE_PRESS, 0, ACTION_B_PRESS},
+    {1, BTN_BIT_C, GESTURE_REPEAT, 200, ACTION_C_REPEAT},
+};
+
+// Clock::Loop() cut down to the buttons and the latency stages
+class TracedLoop
+{
+  public:
+    ButtonInput buttons;
+    GestureEngine gestures;
+    LatencyTrace trace;
+    int actions{0};
+
+    TracedLoop()
+    {
+        gestures.SetBindings(BINDINGS);
+        gestures.handler = GestureEngine::Bind<TracedLoop, &TracedLoop::HandleButtonAction>(*this);
+    }
+
+    void Loop()
+    {
+        bool hadEdges = false;
+        const uint8_t pressedMask = buttons.Sample(hadEdges);
+        if (hadEdges)
+        {
+            trace.Edge(buttons.FirstEdgeTime());
+        }
+        if (hadEdges || pressedMask != 0 || !gestures.IsIdle())
+        {
+            gestures.Update(pressedMask, 1, millis());
+            if (gestures.IsSettled())
+            {
+                trace.EdgesConsumed();
+            }
+        }
+
+        host_advanceMicros(RENDER_US);
+        trace.Mark(LatencyTrace::STAGE_RENDER);
+        host_advanceMicros(TRANSMIT_US);
+        trace.FrameDone();
+        host_advanceMicros(IDLE_US);
+    }
+
+    void RunFor(const uint32_t ms)
+    {
+        const uint32_t end = millis() + ms;
+        while ((int32_t)(millis() - end) < 0)
+        {
+            Loop();
+        }
+    }
+
+    // how many latencies a stage has in the bucket for us
+    uint16_t Count(const LatencyTrace::Stage_e stage, const uint32_t us) const
+    {
+        int bucket = 0;
+        while (bucket < LatencyTrace::TOTAL_BUCKETS - 1 && us >= ((uint32_t)LatencyTrace::FIRST_BUCKET_US << bucket))
+        {
+            ++bucket;
+        }
+        return trace.GetHistogram(stage).buckets[bucket];
+    }
+
+    uint16_t Total(const LatencyTrace::Stage_e stage) const
+    {
+        uint16_t total = 0;
+        for (const uint16_t count : trace.GetHistogram(stage).buckets)
+        {
+            total += count;
+        }
+        return total;
+    }
+
+  private:
+    void HandleButtonAction(const uint8_t action)
+    {
+        trace.Dispatch();
+        ++actions;
+        host_advanceMicros(MODEL_US);
+        trace.Mark(LatencyTrace::STAGE_MODEL);
+    }
+};
+
+// A bouncing press is measured from its first edge, through the debounce
+static void TestBouncingPress()
+{
+    TracedLoop loop;
+    loop.RunFor(10);
+
+    host_setPin(PIN_BTN_B, LOW);
+    host_advanceMicros(150);
+    host_setPin(PIN_BTN_B, HIGH);
+    host_advanceMicros(150);
+    host_setPin(PIN_BTN_B, LOW);
+    loop.RunFor(40);
+    CHECK(loop.actions == 1);
+
+    // the last edge is 300us after the first, and the press is dispatched
+    // on the first loop at least DEBOUNCE_TIME after it
+    const uint32_t loopUs = RENDER_US + TRANSMIT_US + IDLE_US;
+    const uint32_t dispatch = loop.trace.GetHistogram(LatencyTrace::STAGE_DISPATCH).max;
+    CHECK(dispatch >= 300 + GestureEngine::DEBOUNCE_TIME * 1000);
+    CHECK(dispatch < 300 + GestureEngine::DEBOUNCE_TIME * 1000 + loopUs + 1000);
+    CHECK(loop.Total(LatencyTrace::STAGE_DISPATCH) == 1);
+    CHECK(loop.Count(LatencyTrace::STAGE_DISPATCH, dispatch) == 1);
+
+    // and every stage after it adds its part
+    const LatencyTrace::Histogram &model = loop.trace.GetHistogram(LatencyTrace::STAGE_MODEL);
+    const LatencyTrace::Histogram &render = loop.trace.GetHistogram(LatencyTrace::STAGE_RENDER);
+    const LatencyTrace::Histogram &transmit = loop.trace.GetHistogram(LatencyTrace::STAGE_TRANSMIT);
+    CHECK(model.max == dispatch + MODEL_US);
+    CHECK(render.max == model.max + RENDER_US);
+    CHECK(transmit.max == render.max + TRANSMIT_US);
+    CHECK(loop.Count(LatencyTrace::STAGE_TRANSMIT, transmit.max) == 1);
+
+    host_setPin(PIN_BTN_B, HIGH);
+    loop.RunFor(40);
+}
+
+// A press that fires nothing leaves no edge behind, so the repeats it
+// leads to are measured from when they fire, not from the press
+static void TestRepeatAfterSilentPress()
+{
+    TracedLoop loop;
+    loop.RunFor(10);
+
+    host_setPin(PIN_BTN_C, LOW);
+    loop.RunFor(GestureEngine::REPEAT_DELAY + 450);
+    host_setPin(PIN_BTN_C, HIGH);
+    loop.RunFor(40);
+
+    // repeats at 400, 600 and 800ms
+    CHECK(loop.actions == 3);
+    CHECK(loop.Total(LatencyTrace::STAGE_DISPATCH) == 3);
+    CHECK(loop.trace.GetHistogram(LatencyTrace::STAGE_DISPATCH).max == 0);
+    CHECK(loop.trace.GetHistogram(LatencyTrace::STAGE_TRANSMIT).max == MODEL_US + RENDER_US + TRANSMIT_US);
+    CHECK(loop.Count(LatencyTrace::STAGE_TRANSMIT, MODEL_US + RENDER_US + TRANSMIT_US) == 3);
+}
+
+int main()
+{
+    TestBouncingPress();
+    TestRepeatAfterSilentPress();
+    return TestResult();
+}
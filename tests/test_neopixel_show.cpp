@@ -0,0 +1,205 @@
+// The Apollo3 bit loops in apollo3.cpp, run against a fast GPIO that counts
+// the bits sent and reads them back from their high times. The cycle counts
+// they're built from are checked when apollo3.cpp compiles, here as on the
+// clock, and against the cycle counter on the clock only, see
+// getBitLoopError(). Also what show() sends: only the pixels that changed,
+// colors from the palette in indexed mode, and the brightness applied.
+#include <Arduino.h>
+#include <am_hal_gpio.h>
+
+#include "Adafruit_NeoPixel.h"
+#include "check.hpp"
+
+static const uint16_t PIXELS = 30;
+
+// Bits show() sends
+static uint32_t BitsShown(Adafruit_NeoPixel &leds)
+{
+    host_advanceMicros(1000); // past the latch time, or show() waits for it
+    const uint32_t before = host_fastGpioSets;
+    leds.show();
+    return host_fastGpioSets - before;
+}
+
+// Bytes show() sends, as the LEDs read them
+static uint32_t BytesShown(Adafruit_NeoPixel &leds, uint8_t *bytes)
+{
+    host_advanceMicros(1000);
+    host_takeWireBytes(bytes, 0); // anything sent before
+    leds.show();
+    return host_takeWireBytes(bytes, PIXELS * 3);
+}
+
+static void TestSpeed(const neoPixelType type)
+{
+    Adafruit_NeoPixel leds(PIXELS, 1, type);
+    leds.begin();
+    for (uint16_t i = 0; i < PIXELS; ++i)
+    {
+        leds.setPixelColor(i, leds.Color(i, 0x80, 0xff - i));
+    }
+
+    CHECK(BitsShown(leds) == PIXELS * 3 * 8);
+    CHECK(leds.getResends() == 0);
+
+    // interrupt windows between groups of pixels don't lose any bits
+    leds.setInterruptGroup(4);
+    CHECK(BitsShown(leds) == PIXELS * 3 * 8);
+    CHECK(leds.getResends() == 0);
+    leds.setInterruptGroup(0);
+
+    // only as far as the last pixel changed
+    leds.setPartialShow(true);
+    CHECK(BitsShown(leds) == PIXELS * 3 * 8); // starts from a full frame
+    leds.setPixelColor(9, 0x102030);
+    CHECK(BitsShown(leds) == 10 * 3 * 8);
+    CHECK(BitsShown(leds) == 0);
+    leds.setPartialShow(false);
+
+    // from the palette, scaled
+    if (leds.setIndexed(4))
+    {
+        leds.setBrightness(100);
+        CHECK(BitsShown(leds) == PIXELS * 3 * 8);
+    }
+}
+
+// show() sends up to the last pixel that changed since the previous one
+static void TestPartialShow()
+{
+    Adafruit_NeoPixel leds(PIXELS, 1, NEO_GRB + NEO_KHZ800);
+    leds.begin();
+    leds.setPartialShow(true);
+    CHECK(BitsShown(leds) == PIXELS * 3 * 8);
+
+    leds.setPixelColor(7, 0x010203);
+    leds.setPixelColor(3, 0x040506);
+    CHECK(BitsShown(leds) == 8 * 3 * 8);
+
+    // the same colors again aren't changes
+    leds.setPixelColor(7, 0x010203);
+    leds.setPixelColor(3, 0x040506);
+    CHECK(BitsShown(leds) == 0);
+
+    leds.setPixelColor(PIXELS - 1, 0x070809);
+    CHECK(BitsShown(leds) == PIXELS * 3 * 8);
+    leds.setPixelColor(PIXELS, 0x070809); // off the end
+    CHECK(BitsShown(leds) == 0);
+
+    leds.fillMask(10, 0x5, 0x0A0B0C); // pixels 10 and 12
+    CHECK(BitsShown(leds) == 13 * 3 * 8);
+    const uint32_t colors[2] = {0, 0};
+    leds.setPixelColors(0, colors, 2); // already black
+    CHECK(BitsShown(leds) == 0);
+
+    // every pixel changes with the brightness, or when cleared
+    leds.setBrightness(255);
+    CHECK(BitsShown(leds) == 0);
+    leds.setBrightness(100);
+    CHECK(BitsShown(leds) == PIXELS * 3 * 8);
+    leds.clear();
+    CHECK(BitsShown(leds) == PIXELS * 3 * 8);
+}
+
+// A full palette makes room by dropping the colors no pixel uses anymore.
+// Once every color in it is in use, a new color gets the nearest one.
+static void TestPalette()
+{
+    Adafruit_NeoPixel leds(PIXELS, 1, NEO_GRB + NEO_KHZ800);
+    leds.begin();
+    CHECK(leds.setIndexed(4)); // black and three more
+    leds.setPartialShow(true);
+    CHECK(BitsShown(leds) == PIXELS * 3 * 8);
+
+    leds.setPixelColor(0, 0x400000);
+    leds.setPixelColor(1, 0x004000);
+    leds.setPixelColor(2, 0x000040);
+    CHECK(BitsShown(leds) == 3 * 3 * 8);
+
+    // frees the first two colors, then takes their place
+    leds.setPixelColor(0, 0);
+    leds.setPixelColor(1, 0);
+    CHECK(BitsShown(leds) == 2 * 3 * 8);
+    leds.setPixelColor(3, 0x202020);
+    leds.setPixelColor(4, 0x404000);
+
+    // packing the palette renumbers pixel 2, but it's still the same color
+    CHECK(BitsShown(leds) == 5 * 3 * 8);
+
+    // full, and all of it in use
+    leds.setPixelColor(5, 0x400800);
+
+    const uint32_t expected[] = {0, 0, 0x000040, 0x202020, 0x404000, 0x404000};
+    uint8_t bytes[PIXELS * 3];
+    CHECK(BytesShown(leds, bytes) == 6 * 3);
+    for (int i = 0; i < 6; ++i)
+    {
+        CHECK(leds.getPixelColor(i) == expected[i]);
+        CHECK(bytes[i * 3] == (uint8_t)(expected[i] >> 8));
+        CHECK(bytes[i * 3 + 1] == (uint8_t)(expected[i] >> 16));
+        CHECK(bytes[i * 3 + 2] == (uint8_t)expected[i]);
+    }
+}
+
+// what setBrightness() made of a color byte when it scaled pixels as they
+// were set, before show() applied the brightness
+static uint8_t SetAtBrightness(const uint8_t value, const uint8_t brightness)
+{
+    const uint8_t stored = brightness + 1; // 0 for full brightness
+    return stored ? (value * stored) >> 8 : value;
+}
+
+// show() applies the brightness as it sends, to the same bytes as before
+static void TestBrightness(const bool indexed)
+{
+    Adafruit_NeoPixel leds(PIXELS, 1, NEO_GRB + NEO_KHZ800);
+    leds.begin();
+    if (indexed)
+    {
+        CHECK(leds.setIndexed(PIXELS + 1));
+    }
+
+    uint32_t colors[PIXELS];
+    for (uint16_t i = 0; i < PIXELS; ++i)
+    {
+        const uint8_t r = i * 255 / (PIXELS - 1);
+        colors[i] = leds.Color(r, 255 - r, (i * 97) & 0xFF);
+    }
+    leds.setPixelColors(0, colors, PIXELS);
+
+    static const uint8_t LEVELS[] = {0, 1, 2, 63, 64, 127, 128, 200, 254, 255};
+    for (const uint8_t level : LEVELS)
+    {
+        leds.setBrightness(level);
+        uint8_t bytes[PIXELS * 3];
+        CHECK(BytesShown(leds, bytes) == PIXELS * 3);
+
+        int mismatches = 0;
+        for (uint16_t i = 0; i < PIXELS; ++i)
+        {
+            mismatches += bytes[i * 3] != SetAtBrightness(colors[i] >> 8, level);
+            mismatches += bytes[i * 3 + 1] != SetAtBrightness(colors[i] >> 16, level);
+            mismatches += bytes[i * 3 + 2] != SetAtBrightness(colors[i], level);
+            mismatches += leds.getPixelColor(i) != colors[i];
+        }
+        CHECK(mismatches == 0);
+    }
+}
+
+int main()
+{
+    TestSpeed(NEO_GRB + NEO_KHZ800);
+    TestSpeed(NEO_GRB + NEO_KHZ400);
+
+    // RGBW sends four bytes a pixel
+    Adafruit_NeoPixel rgbw(PIXELS, 1, NEO_GRBW + NEO_KHZ800);
+    rgbw.begin();
+    CHECK(BitsShown(rgbw) == PIXELS * 4 * 8);
+
+    TestPartialShow();
+    TestPalette();
+    TestBrightness(false);
+    TestBrightness(true);
+
+    return TestResult();
+}
@@ -0,0 +1,126 @@
+// The drift estimator and the trim it leads to, against an internal RTC
+// whose rate is off by a given amount plus whatever the trim adds
+#include <Arduino.h>
+
+#include "check.hpp"
+#include "rtc_drift.hpp"
+
+// An RTC that gains ratePpb, started in step with the reference at
+// startSecond, read after elapsed reference seconds
+static int32_t LocalHundredths(const int32_t startSecond, const int32_t elapsed, const int64_t ratePpb)
+{
+    const int64_t hundredths = (int64_t)(startSecond + elapsed) * 100 + elapsed * ratePpb / 10000000;
+    return (int32_t)(hundredths % RtcDriftEstimator::HUNDREDTHS_PER_DAY);
+}
+
+static int32_t RefSecond(const int32_t startSecond, const int32_t elapsed)
+{
+    return (startSecond + elapsed) % RtcDriftEstimator::SECONDS_PER_DAY;
+}
+
+// Samples once an hour until the estimator has a drift, and returns it.
+// Sets hours to how many hours that took.
+static int32_t Measure(const int32_t startSecond, const int64_t ratePpb, int &hours)
+{
+    RtcDriftEstimator drift;
+    int32_t driftPpb = 0;
+    for (hours = 0; hours <= 24; ++hours)
+    {
+        const int32_t elapsed = hours * 3600;
+        if (drift.AddSample(RefSecond(startSecond, elapsed), LocalHundredths(startSecond, elapsed, ratePpb), driftPpb))
+        {
+            return driftPpb;
+        }
+    }
+    return 0;
+}
+
+// what one hundredth of a second is worth over the minimum baseline
+static const int32_t RESOLUTION_PPB = 10000000 / RtcDriftEstimator::MIN_BASELINE_SECONDS + 1;
+
+// The trim from a measurement brings the RTC to within a step of the
+// reference, which takes the sign of CALXT the right way around
+static void TestCorrects(const int64_t oscillatorPpb)
+{
+    int trim = 0;
+    for (int round = 0; round < 3; ++round)
+    {
+        const int64_t rate = oscillatorPpb + (int64_t)trim * RtcDriftEstimator::TRIM_STEP_PPB;
+        int hours = 0;
+        const int32_t driftPpb = Measure(10 * 3600L, rate, hours);
+        CHECK(hours == 6);
+        CHECK(driftPpb >= rate - RESOLUTION_PPB && driftPpb <= rate + RESOLUTION_PPB);
+        trim = RtcDriftEstimator::CorrectedTrim(trim, driftPpb);
+    }
+
+    CHECK(oscillatorPpb > 0 ? trim < 0 : trim > 0);
+    const int64_t residual = oscillatorPpb + (int64_t)trim * RtcDriftEstimator::TRIM_STEP_PPB;
+    CHECK(residual > -RtcDriftEstimator::TRIM_STEP_PPB && residual < RtcDriftEstimator::TRIM_STEP_PPB);
+}
+
+// Both clocks pass midnight between samples
+static void TestAcrossMidnight()
+{
+    int hours = 0;
+    const int32_t driftPpb = Measure(21 * 3600L + 1800, 30000, hours);
+    CHECK(hours == 6);
+    CHECK(driftPpb >= 30000 - RESOLUTION_PPB && driftPpb <= 30000 + RESOLUTION_PPB);
+
+    // with the RTC just before midnight and the reference just after
+    RtcDriftEstimator drift;
+    int32_t driftPpb2 = 0;
+    CHECK(!drift.AddSample(0, RtcDriftEstimator::HUNDREDTHS_PER_DAY - 50, driftPpb2));
+    CHECK(drift.AddSample(RtcDriftEstimator::MIN_BASELINE_SECONDS, RtcDriftEstimator::MIN_BASELINE_SECONDS * 100L,
+                          driftPpb2));
+    CHECK(driftPpb2 == 50 * 10000000LL / RtcDriftEstimator::MIN_BASELINE_SECONDS);
+}
+
+// Nothing until the samples span MIN_BASELINE_SECONDS, however much they've
+// drifted
+static void TestMinimumBaseline()
+{
+    RtcDriftEstimator drift;
+    int32_t driftPpb = 12345;
+    CHECK(!drift.AddSample(0, 0, driftPpb));
+    CHECK(!drift.AddSample(3600, 3600 * 100L + 500, driftPpb));
+    CHECK(!drift.AddSample(RtcDriftEstimator::MIN_BASELINE_SECONDS - 1,
+                           (RtcDriftEstimator::MIN_BASELINE_SECONDS - 1) * 100L + 500, driftPpb));
+    CHECK(driftPpb == 12345);
+    CHECK(drift.AddSample(RtcDriftEstimator::MIN_BASELINE_SECONDS, RtcDriftEstimator::MIN_BASELINE_SECONDS * 100L,
+                          driftPpb));
+    CHECK(driftPpb == 0);
+
+    // Reset() starts a new baseline
+    drift.Reset();
+    CHECK(!drift.AddSample(RtcDriftEstimator::MIN_BASELINE_SECONDS + 3600,
+                           (RtcDriftEstimator::MIN_BASELINE_SECONDS + 3600) * 100L, driftPpb));
+}
+
+static void TestTrimSteps()
+{
+    const int32_t step = RtcDriftEstimator::TRIM_STEP_PPB;
+    CHECK(RtcDriftEstimator::CorrectedTrim(0, 0) == 0);
+    CHECK(RtcDriftEstimator::CorrectedTrim(0, step / 2 - 1) == 0);
+    CHECK(RtcDriftEstimator::CorrectedTrim(0, step / 2 + 1) == -1);
+    CHECK(RtcDriftEstimator::CorrectedTrim(0, -step / 2 - 1) == 1);
+    CHECK(RtcDriftEstimator::CorrectedTrim(10, 3 * step) == 7);
+
+    // CALXT's limits
+    CHECK(RtcDriftEstimator::CorrectedTrim(RtcDriftEstimator::TRIM_MAX - 1, -10 * step) == RtcDriftEstimator::TRIM_MAX);
+    CHECK(RtcDriftEstimator::CorrectedTrim(RtcDriftEstimator::TRIM_MIN, 5 * step) == RtcDriftEstimator::TRIM_MIN);
+    CHECK(RtcDriftEstimator::CorrectedTrim(0, 2000 * step) == RtcDriftEstimator::TRIM_MIN);
+    CHECK(RtcDriftEstimator::ClampTrim(5000) == RtcDriftEstimator::TRIM_MAX);
+    CHECK(RtcDriftEstimator::ClampTrim(-5000) == RtcDriftEstimator::TRIM_MIN);
+    CHECK(RtcDriftEstimator::ClampTrim(-12) == -12);
+}
+
+int main()
+{
+    TestCorrects(50000);  // fast
+    TestCorrects(-50000); // slow
+    TestCorrects(1500);
+    TestAcrossMidnight();
+    TestMinimumBaseline();
+    TestTrimSteps();
+    return TestResult();
+}
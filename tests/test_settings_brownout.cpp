@@ -0,0 +1,79 @@
+// The brownout interrupt flushing settings while the main loop commits them
+#include "host_config.hpp"
+#include <memory>
+
+#include "check.hpp"
+#include "digit.hpp"
+#include "fake_flash.hpp"
+#include "settings.hpp"
+
+static void BrownoutIsr()
+{
+    Settings::FlushFromInterrupt();
+}
+
+static void ReloadAndCheck(const uint32_t brightness, const uint32_t color)
+{
+    fake_flash::SetInterrupt(nullptr);
+    Settings reloaded;
+    CHECK(reloaded.Get(SETTING_CUR_BRIGHTNESS) == brightness);
+    CHECK(reloaded.Get(SETTING_COLOR) == color);
+}
+
+// The interrupt arrives during a flash operation started by Update(), so the
+// flush has to wait until that's done
+static void TestInterruptDuringUpdate()
+{
+    fake_flash::Reset();
+    Settings settings;
+    settings.Set(SETTING_CUR_BRIGHTNESS, 99);
+    settings.Save();
+    delay(2000);
+
+    fake_flash::SetInterrupt(BrownoutIsr);
+    settings.Update();
+    CHECK(fake_flash::NestedOperations() == 0);
+    CHECK(!settings.HasPendingWork());
+
+    ReloadAndCheck(99, 192);
+}
+
+// The interrupt arrives while the main loop flushes, which already writes
+// everything
+static void TestInterruptDuringFlush()
+{
+    fake_flash::Reset();
+    Settings settings;
+    settings.Set(SETTING_COLOR, 17);
+    settings.Save();
+
+    fake_flash::SetInterrupt(BrownoutIsr);
+    settings.Flush();
+    CHECK(fake_flash::NestedOperations() == 0);
+    CHECK(!settings.HasPendingWork());
+
+    ReloadAndCheck(64, 17);
+}
+
+// Between flash operations the interrupt flushes right away, even when the
+// commit hasn't started yet
+static void TestInterruptBetweenOperations()
+{
+    fake_flash::Reset();
+    Settings settings;
+    settings.Set(SETTING_CUR_BRIGHTNESS, 12);
+    settings.Save();
+
+    BrownoutIsr();
+    CHECK(!settings.HasPendingWork());
+
+    ReloadAndCheck(12, 192);
+}
+
+int main()
+{
+    TestInterruptDuringUpdate();
+    TestInterruptDuringFlush();
+    TestInterruptBetweenOperations();
+    return TestResult();
+}
@@ -0,0 +1,146 @@
+// Records written by firmware with a different number of settings, and the
+// emulated EEPROM block from before the journal
+#include "host_config.hpp"
+#include <memory>
+
+#include "check.hpp"
+#include "digit.hpp"
+#include "fake_flash.hpp"
+#include "settings.hpp"
+
+// SettingsRecord as it was before its last setting was added
+struct OlderRecord
+{
+    uint8_t version;
+    uint8_t count;
+    uint16_t values[TOTAL_SETTINGS - 1];
+};
+
+// SettingsRecord with a setting that this firmware doesn't know about yet
+struct NewerRecord
+{
+    uint8_t version;
+    uint8_t count;
+    uint16_t values[TOTAL_SETTINGS + 1];
+};
+
+template <typename Record> static void Commit(const Record &record)
+{
+    SettingsJournal journal(&record, sizeof(record));
+    Record stored;
+    journal.Load(&stored);
+    while (journal.Step())
+    {
+    }
+}
+
+static void TestOlderRecordLoads()
+{
+    fake_flash::Reset();
+    OlderRecord older{2, TOTAL_SETTINGS - 1, {}};
+    for (uint8_t i = 0; i < TOTAL_SETTINGS - 1; ++i)
+    {
+        older.values[i] = 100 + i;
+    }
+    older.values[SETTING_DIGIT_TYPE] = DT_PIXELS;
+    Commit(older);
+
+    Settings settings;
+    CHECK(settings.Get(SETTING_DIGIT_TYPE) == DT_PIXELS);
+    for (uint8_t i = SETTING_CUR_BRIGHTNESS; i < TOTAL_SETTINGS - 1; ++i)
+    {
+        CHECK(settings.Get((SettingNames_e)i) == 100u + i);
+    }
+    CHECK(settings.Get(SETTING_RTC_TRIM) == 0); // the default
+    CHECK(!settings.HasPendingWork());
+
+    // the next save is written at the current size and loads as is
+    settings.Set(SETTING_RTC_TRIM, 7);
+    settings.Save();
+    settings.Flush();
+
+    Settings reloaded;
+    CHECK(reloaded.Get(SETTING_DIGIT_TYPE) == DT_PIXELS);
+    CHECK(reloaded.Get(SETTING_COLOR) == 100u + SETTING_COLOR);
+    CHECK(reloaded.Get(SETTING_RTC_TRIM) == 7);
+}
+
+static void TestNewerRecordLoads()
+{
+    fake_flash::Reset();
+    NewerRecord newer{2, TOTAL_SETTINGS + 1, {}};
+    for (uint8_t i = 0; i < TOTAL_SETTINGS + 1; ++i)
+    {
+        newer.values[i] = 200 + i;
+    }
+    newer.values[SETTING_DIGIT_TYPE] = DT_EDGE_LIT;
+    Commit(newer);
+
+    Settings settings;
+    CHECK(settings.Get(SETTING_DIGIT_TYPE) == DT_EDGE_LIT);
+    for (uint8_t i = SETTING_CUR_BRIGHTNESS; i < TOTAL_SETTINGS; ++i)
+    {
+        CHECK(settings.Get((SettingNames_e)i) == 200u + i);
+    }
+}
+
+// After a firmware update the log holds records of both sizes, and the newest
+// one wins whichever size it is
+static void TestMixedSizes()
+{
+    fake_flash::Reset();
+    OlderRecord older{2, TOTAL_SETTINGS - 1, {DT_PIXELS, 10}};
+    Commit(older);
+    SettingsRecord current{2, TOTAL_SETTINGS, {DT_PIXELS, 20}};
+    Commit(current);
+    older.values[SETTING_CUR_BRIGHTNESS] = 30;
+    Commit(older);
+
+    OlderRecord loaded;
+    SettingsJournal journal(&loaded, sizeof(loaded));
+    CHECK(journal.Load(&loaded));
+    CHECK(loaded.values[SETTING_CUR_BRIGHTNESS] == 30);
+
+    Settings settings;
+    CHECK(settings.Get(SETTING_CUR_BRIGHTNESS) == 30);
+}
+
+// The EEPROM block held a uint32_t per setting, through the transition
+// type. What follows it in EEPROM isn't a setting.
+static void TestEepromMigration()
+{
+    fake_flash::Reset();
+    uint32_t block[TOTAL_SETTINGS];
+    memset(block, 0x5A, sizeof(block));
+    for (int i = 0; i <= SETTING_TRANSITION_TYPE; ++i)
+    {
+        block[i] = 0;
+    }
+    block[SETTING_DIGIT_TYPE] = DT_PIXELS;
+    block[SETTING_COLOR] = 77;
+    block[SETTING_TRANSITION_TYPE] = 3;
+    memcpy(EEPROM.bytes, block, sizeof(block));
+
+    {
+        Settings settings;
+        CHECK(settings.Get(SETTING_DIGIT_TYPE) == DT_PIXELS);
+        CHECK(settings.Get(SETTING_COLOR) == 77);
+        CHECK(settings.Get(SETTING_TRANSITION_TYPE) == 3);
+        CHECK(settings.Get(SETTING_RTC_TRIM) == 0);
+    }
+
+    // converted once, and from then on loaded from the journal
+    memset(EEPROM.bytes, 0xFF, sizeof(EEPROM.bytes));
+    Settings reloaded;
+    CHECK(reloaded.Get(SETTING_COLOR) == 77);
+    CHECK(reloaded.Get(SETTING_TRANSITION_TYPE) == 3);
+}
+
+int main()
+{
+    TestOlderRecordLoads();
+    TestNewerRecordLoads();
+    TestMixedSizes();
+    TestEepromMigration();
+    return TestResult();
+}
@@ -0,0 +1,76 @@
+// Settings listeners: called on subscribing and after each change, and
+// refused rather than dropped once there's no room for more. A consumer
+// that's refused reads the settings itself.
+#include "host_config.hpp"
+#include <memory>
+
+#include "check.hpp"
+#include "digit.hpp"
+#include "fake_flash.hpp"
+#include "reversible_neopixels.hpp"
+#include "settings.hpp"
+
+struct Listener
+{
+    int calls{0};
+    uint32_t color{0};
+
+    void OnSettingsChanged(const Settings &settings)
+    {
+        ++calls;
+        color = settings.Get(SETTING_COLOR);
+    }
+
+    SettingsListener Bound()
+    {
+        return SettingsListener::Bind<Listener, &Listener::OnSettingsChanged>(*this);
+    }
+};
+
+int main()
+{
+    fake_flash::Reset();
+    Settings settings;
+
+    Listener listeners[Settings::MAX_LISTENERS];
+    for (Listener &listener : listeners)
+    {
+        CHECK(settings.Subscribe(listener.Bound()));
+        CHECK(listener.calls == 1);
+    }
+
+    // full: refused, and never called
+    Listener extra;
+    CHECK(!settings.Subscribe(extra.Bound()));
+    settings.Set(SETTING_COLOR, 40);
+    CHECK(extra.calls == 0);
+    for (Listener &listener : listeners)
+    {
+        CHECK(listener.calls == 2);
+        CHECK(listener.color == 40);
+    }
+
+    // a slot freed by Unsubscribe() can be taken again
+    settings.Unsubscribe(&listeners[2]);
+    CHECK(settings.Subscribe(extra.Bound()));
+    CHECK(extra.calls == 1);
+    settings.Set(SETTING_COLOR, 80);
+    CHECK(extra.calls == 2);
+    CHECK(extra.color == 80);
+    CHECK(listeners[2].calls == 2);
+
+    // the table is full again, so the LEDs read SETTING_FLIP_DISPLAY
+    // themselves, and still follow it
+    ReversibleNeopixels leds(settings, NUM_LEDS, PIN_FOR_LEDS, NEO_GRB + NEO_KHZ800);
+    leds.begin();
+    const uint16_t lastFlipped = NUM_LEDS - 3;
+    settings.Set(SETTING_FLIP_DISPLAY, 1);
+    leds.setPixelColor(0, 0x102030);
+    CHECK(leds.getPixelColor(lastFlipped) == 0x102030);
+    CHECK(leds.getPixelColor(0) == 0);
+    settings.Set(SETTING_FLIP_DISPLAY, 0);
+    leds.setPixelColor(1, 0x405060);
+    CHECK(leds.getPixelColor(1) == 0x405060);
+
+    return TestResult();
+}
@@ -0,0 +1,199 @@
+#!/usr/bin/env python3
+"""Assembler for the animation programs run by firmware/animation_vm.hpp.
+
+Usage: tools/animasm.py tools/animations/*.anim > firmware/animation_programs.hpp
+
+Each .anim file holds one program:
+
+    .animation ANIM_GLOW        ; the AnimationType_e it's used for
+    .interval 25                ; ms between frames it needs, if it changes
+                                ; more often than once a second
+    start:
+        ldi     r0, 255         ; registers are r0..r7
+        in      r1, wheel       ; inputs are IN_* without the prefix
+        color   all, r1         ; digits are 0..5, all, or a register
+        bright  r2, r0
+        yield
+        jmp     start
+
+Opcode and input names are read from animation_vm.hpp, so the two can't
+get out of sync.
+"""
+
+import os
+import re
+import sys
+
+VM_HEADER = os.path.join(os.path.dirname(__file__), "..", "firmware", "animation_vm.hpp")
+
+# operand kinds for each opcode, in order: r register, w 16-bit immediate,
+# i 8-bit immediate, p input port, a address, d digit
+FORMATS = {
+    "HALT": "",
+    "YIELD": "",
+    "LDI": "rw",
+    "MOV": "rr",
+    "ADD": "rr",
+    "SUB": "rr",
+    "ADDI": "ri",
+    "SHL": "ri",
+    "SHR": "ri",
+    "MIN": "rr",
+    "MAX": "rr",
+    "AND": "rr",
+    "SIN": "rr",
+    "IN": "rp",
+    "JMP": "a",
+    "JZ": "ra",
+    "JNZ": "ra",
+    "JLT": "rra",
+    "JGE": "rra",
+    "COLOR": "dr",
+    "BRIGHT": "dr",
+}
+
+ALL_DIGITS = 0xFF
+DIGIT_IN_REGISTER = 0x80
+NUM_DIGITS = 6
+MAX_LENGTH = 255
+
+
+class AsmError(Exception):
+    pass
+
+
+def read_enum(text, name):
+    body = re.search(r"enum " + name + r"\s*\{(.*?)\};", text, re.S).group(1)
+    names = re.findall(r"^\s*([A-Z_0-9]+),", body, re.M)
+    return {n: i for i, n in enumerate(names) if not n.startswith("TOTAL_")}
+
+
+def parse_register(token):
+    m = re.fullmatch(r"r([0-7])", token)
+    if not m:
+        raise AsmError("expected a register r0..r7, got '%s'" % token)
+    return int(m.group(1))
+
+
+def parse_number(token, low, high):
+    try:
+        value = int(token, 0)
+    except ValueError:
+        raise AsmError("expected a number, got '%s'" % token)
+    if not low <= value <= high:
+        raise AsmError("%d is out of range %d..%d" % (value, low, high))
+    return value
+
+
+def assemble(path, opcodes, inputs):
+    animation = None
+    interval = 0
+    labels = {}
+    instructions = []  # (line number, source, mnemonic, operands)
+    address = 0
+
+    # first pass: find the labels
+    with open(path) as f:
+        for number, line in enumerate(f, 1):
+            source = line.rstrip()
+            code = line.split(";")[0].strip()
+            if not code:
+                continue
+            if code.startswith(".animation"):
+                animation = code.split()[1]
+                continue
+            if code.startswith(".interval"):
+                try:
+                    interval = parse_number(code.split()[1], 1, 255)
+                except AsmError as e:
+                    raise AsmError("%s:%d: %s" % (path, number, e))
+                continue
+            while ":" in code:
+                label, code = code.split(":", 1)
+                labels[label.strip()] = address
+                code = code.strip()
+            if not code:
+                continue
+
+            parts = code.split(None, 1)
+            mnemonic = parts[0].upper()
+            operands = [o.strip() for o in parts[1].split(",")] if len(parts) > 1 else []
+            if mnemonic not in FORMATS or "OP_" + mnemonic not in opcodes:
+                raise AsmError("%s:%d: unknown instruction '%s'" % (path, number, parts[0]))
+            if len(operands) != len(FORMATS[mnemonic]):
+                raise AsmError("%s:%d: wrong number of operands for %s" % (path, number, mnemonic))
+
+            instructions.append((number, source, mnemonic, operands))
+            address += 1 + len(FORMATS[mnemonic]) + FORMATS[mnemonic].count("w")
+
+    if animation is None:
+        raise AsmError("%s: missing .animation" % path)
+
+    # second pass: encode
+    listing = []
+    for number, source, mnemonic, operands in instructions:
+        try:
+            encoded = [opcodes["OP_" + mnemonic]]
+            for kind, token in zip(FORMATS[mnemonic], operands):
+                if kind == "r":
+                    encoded.append(parse_register(token))
+                elif kind == "w":
+                    value = parse_number(token, -32768, 65535) & 0xFFFF
+                    encoded += [value & 0xFF, value >> 8]
+                elif kind == "i":
+                    encoded.append(parse_number(token, -128, 127) & 0xFF)
+                elif kind == "p":
+                    name = "IN_" + token.upper()
+                    if name not in inputs:
+                        raise AsmError("unknown input '%s'" % token)
+                    encoded.append(inputs[name])
+                elif kind == "a":
+                    if token not in labels:
+                        raise AsmError("unknown label '%s'" % token)
+                    encoded.append(labels[token])
+                elif kind == "d":
+                    if token == "all":
+                        encoded.append(ALL_DIGITS)
+                    elif token.startswith("r"):
+                        encoded.append(DIGIT_IN_REGISTER | parse_register(token))
+                    else:
+                        encoded.append(parse_number(token, 0, NUM_DIGITS - 1))
+        except AsmError as e:
+            raise AsmError("%s:%d: %s" % (path, number, e))
+        listing.append((encoded, source))
+
+    length = sum(len(e) for e, _ in listing)
+    if length > MAX_LENGTH:
+        raise AsmError("%s: program is %d bytes, the limit is %d" % (path, length, MAX_LENGTH))
+    return animation, interval, listing
+
+
+def main():
+    with open(VM_HEADER) as f:
+        text = f.read()
+    opcodes = read_enum(text, "Opcode_e")
+    inputs = read_enum(text, "Input_e")
+
+    out = ["#pragma once", "// Generated by tools/animasm.py from tools/animations, do not edit.", ""]
+    table = []
+    try:
+        for path in sorted(sys.argv[1:]):
+            animation, interval, listing = assemble(path, opcodes, inputs)
+            name = "PROGRAM_" + animation[len("ANIM_"):]
+            out.append("static const uint8_t %s[] = {" % name)
+            for encoded, source in listing:
+                out.append("    %-28s // %s" % (", ".join("0x%02X" % b for b in encoded) + ",", source.strip()))
+            out.append("};")
+            out.append("")
+            table.append("    {%s, %s, sizeof(%s), %d}," % (animation, name, name, interval))
+    except AsmError as e:
+        sys.exit("error: %s" % e)
+
+    out.append("static const AnimationProgram ANIMATION_PROGRAMS[] = {")
+    out.extend(table)
+    out.append("};")
+    print("\n".join(out))
+
+
+if __name__ == "__main__":
+    main()